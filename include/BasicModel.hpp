@@ -2,6 +2,16 @@
 #define _DROCK_BASIC_MODEL_HPP
 
 #include <ComponentNetwork.hpp>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include <ostream>
+
+namespace YAML {
+class Emitter;
+class Node;
+}
 
 namespace Drock {
 
@@ -23,8 +33,50 @@ class Model : public Component::Network
         Model(const Hypergraph& base);
         ~Model();
 
+        // Store the whole graph. Entities are emitted one after another into a stream with a large buffer,
+        // so the serialized graph never has to be held in memory as a whole.
+        bool saveTo(const std::string& fileName, const std::size_t bufferSize=(16 << 20));
+        void saveTo(std::ostream& out);
+
+        // Report the number of entities and their estimated memory footprint (UID and label strings, references to other
+        // entities and container overhead) per category: components, parts, interfaces, relations, configs and other.
+        // Totals are broken down per domain and per component type. The report is written as YAML.
+        // NOTE: Entities related to components of several domains (or types) are counted for each of them
+        // The estimates assume a std::map like storage: Each UID is stored twice (as key and as id of the entity) and each entity
+        // costs a tree node (4*sizeof(void*)) plus its from/to containers (2*sizeof(Hyperedges)). A string costs sizeof(std::string)
+        // plus its capacity (+1) unless it fits the small string buffer. Allocator overhead is not taken into account.
+        bool reportMemory(const std::string& fileName);
+        void reportMemory(std::ostream& out);
+
+        // Sharded storage: One file per domain plus a core file (meta model etc.) and a manifest (shards.yml) in a directory.
+        // Relations to entities of other shards are kept as stubs, so any subset of shards can be loaded.
+        // NOTE: Without domains, all (loaded) domains are stored
+        // NOTE: loadShards returns false if the manifest is missing or a manifest/shard cannot be parsed
+        bool saveShards(const std::string& directory, const std::vector<std::string>& domains=std::vector<std::string>());
+        bool loadShards(const std::string& directory, const std::vector<std::string>& domains, const bool withDependencies=false);
+
+        // Merge another graph (e.g. a stored catalogue) into this model.
+        // NOTE: Indices are rebuilt lazily, so merging several graphs costs roughly the sum of their sizes
+        Hyperedges merge(const Hypergraph& other);
+
+        // NOTE: Results are cached until the exported component (or the whole graph) changes. Only changes made by the methods of
+        // this class are tracked. After changing the graph by other means, e.g. by the inherited factFrom or get().updateLabel,
+        // invalidate() has to be called. Otherwise outdated results are returned.
         std::string domainSpecificExport(const UniqueId& uid);
+        // NOTE: A single spec is imported as is, without validation: Parts referring to unknown models are dropped silently.
+        // Use the overload below (with one spec) to skip invalid specs instead.
         bool domainSpecificImport(const std::string& serialized);
+        // Import several specs regardless of their order: Specs are sorted by the models their parts refer to
+        // and each wave of independent specs is parsed and validated in parallel, then committed in order.
+        // NOTE: Specs referring to models which are neither known nor provided by (successfully imported) specs are skipped
+        bool domainSpecificImport(const std::vector<std::string>& serialized);
+
+        // Has to be called if the graph has been changed by other means than the methods of this class.
+        // Without a component uid everything is considered to be changed.
+        void invalidate(const UniqueId& componentUid="");
+
+        // Extract the domain from a component UID (see getComponentUid)
+        static std::string domainOf(const UniqueId& componentUid);
 
         // Generate UIDs for fast lookup
         UniqueId getDomainUid(const std::string& domain);
@@ -37,9 +89,34 @@ class Model : public Component::Network
         Hyperedges hasConfig(const Hyperedges& parentUids, const Hyperedges& childrenUids);
         Hyperedges instantiateConfigOnce(const Hyperedges& parentUids, const std::string& label="");
 
-        // Query config
+        // Query config (answered from the index of HasConfig facts)
         Hyperedges configsOf(const Hyperedges& uids, const std::string& label="");
 
+        // Query the catalogue (answered from indices, the cost depends on the size of the result only)
+        Hyperedges componentsOfDomain(const UniqueId& domainUid);
+        Hyperedges componentsOfType(const UniqueId& typeUid);
+        Hyperedges componentsOfDomainAndType(const UniqueId& domainUid, const UniqueId& typeUid);
+        Hyperedges versionsOf(const UniqueId& componentUid);
+
+        // Query facts of a relation pointing from any of fromUids to any of toUids
+        // NOTE: Facts are indexed per relation and endpoint, so only facts touching the given entities are considered
+        Hyperedges factsBetween(const UniqueId& relUid, const Hyperedges& fromUids, const Hyperedges& toUids, const std::string& label="");
+
+        // Instantiate models together with all their parts (and the parts of these parts, etc.)
+        // NOTE: The structure of every model is queried only once and reused for all further instances of it
+        Hyperedges instantiateDeepFrom(const Hyperedges& modelUids, const std::string& label="");
+
+        // Connectivity between models, parts and instances: via connected interfaces, alias interfaces (both ways) and typed edges
+        // NOTE: Answered from a compiled adjacency (CSR). After an import, only the connections of the imported models (and their parts)
+        // are collected again and patched into the adjacency. It is recompiled only once the patches outnumber the compiled connections.
+        // Any other change causes the connections of all models to be collected again.
+        // Number of hops from any of uids to every entity reachable from them (uids themselves have distance 0)
+        std::map<UniqueId, std::size_t> distancesFrom(const Hyperedges& uids, const TraversalDirection dir=TraversalDirection::FORWARD);
+        // All entities reachable from any of uids within maxHops (0 means unlimited), excluding uids themselves
+        Hyperedges reachableFrom(const Hyperedges& uids, const TraversalDirection dir=TraversalDirection::FORWARD, const std::size_t maxHops=0);
+        // Shortest path from fromUid to toUid (both included), empty if toUid cannot be reached
+        std::vector<UniqueId> pathBetween(const UniqueId& fromUid, const UniqueId& toUid, const TraversalDirection dir=TraversalDirection::FORWARD);
+
         // Check if we are in the SOFTWARE domain
         bool inSoftwareDomain(const UniqueId& domainUid);
         bool isInput(const UniqueId& interfaceDirUid);
@@ -47,6 +124,133 @@ class Model : public Component::Network
 
     protected:
         void setupMetaModel();
+        bool importSpec(const YAML::Node& spec);
+
+        // Serialize the given entities as a sequence of id, label, from and to
+        void emit(YAML::Emitter& out, const Hyperedges& uids, const bool withRelations=true);
+
+        // All entities belonging to the given components: versions, parts, interfaces, configs and the relations starting at them
+        Hyperedges entitiesOf(const Hyperedges& componentUids);
+
+        // Write the given entities (and stubs for everything they refer to) into a shard file
+        bool writeShard(const std::string& fileName, const Hyperedges& uids, Hyperedges& stubUids);
+
+        // Estimated footprint of entities, grouped by category (see reportMemory)
+        struct Footprint
+        {
+            std::size_t entities;
+            std::size_t uidBytes;
+            std::size_t labelBytes;
+            std::size_t referenceBytes;
+            std::size_t overheadBytes;
+        };
+        typedef std::map<std::string, Footprint> Footprints;
+        Footprints footprintsOf(const Hyperedges& uids, const std::unordered_map<UniqueId, std::string>& categories);
+        static void emitFootprints(YAML::Emitter& out, const Footprints& footprints);
+
+        // Catalogue indices: domain -> components, type -> components and component -> versions
+        typedef std::unordered_map< UniqueId, std::set<UniqueId> > Index;
+        void rebuildIndices();
+        void ensureIndices();
+        bool indicesValid;
+        static Hyperedges lookup(const Index& index, const UniqueId& key);
+        Index domainIndex;
+        Index typeIndex;
+        Index versionIndex;
+
+        // Fact indices: relation -> (entity the fact points from/to -> facts). Built per relation on first use
+        typedef std::unordered_map< UniqueId, Index > FactIndex;
+        void indexFacts(const UniqueId& relUid, const Hyperedges& factUids);
+        FactIndex factsFromIndex;
+        FactIndex factsToIndex;
+
+        // Memoized structure of a model version: its parts, their configs, their interconnections and the interfaces aliasing theirs
+        struct DeepTemplate
+        {
+            struct Part
+            {
+                UniqueId modelUid;
+                std::string label;
+                std::vector<std::string> configs;
+            };
+            struct Edge
+            {
+                std::size_t from;
+                std::size_t to;
+                UniqueId relUid; // empty if this is a connection between interfaces
+                std::string fromInterface;
+                std::string toInterface;
+                std::string label;
+                std::vector<std::string> configs;
+            };
+            struct Alias
+            {
+                std::string label;
+                std::size_t part;
+                std::string originalLabel;
+            };
+            std::vector<Part> parts;
+            std::vector<Edge> edges;
+            std::vector<Alias> aliases;
+        };
+        const DeepTemplate& deepTemplateOf(const UniqueId& modelUid);
+        Hyperedges instantiateDeepFrom(const UniqueId& modelUid, const std::string& label, Hyperedges& expandingUids);
+
+        std::map<UniqueId, DeepTemplate> deepTemplates;
+        std::size_t deepTemplatesGeneration;
+
+        // Mutation tracking: Every change increments the generation and is either attributed
+        // to a single component (the one being imported) or to the graph as a whole
+        std::size_t generation;
+        std::size_t globalGeneration;
+        std::unordered_map<UniqueId, std::size_t> componentGenerations;
+        UniqueId changingComponentUid;
+        void changed(const UniqueId& componentUid="");
+
+        struct CachedExport
+        {
+            std::size_t generation;
+            UniqueId componentUid;
+            std::string result;
+        };
+        std::unordered_map<UniqueId, CachedExport> exportCache;
+
+        // Shards loaded so far and entities of other shards known as stubs only
+        bool coreShardLoaded;
+        std::set<std::string> loadedShards;
+        std::set<UniqueId> shardStubUids;
+
+        // Connectivity: Connections derived from the interfaces and facts of an entity, compiled into forward and inverse adjacencies
+        typedef std::vector< std::pair<UniqueId, UniqueId> > Connections;
+        struct Adjacency
+        {
+            std::vector<std::size_t> offsets;
+            std::vector<std::size_t> targets;
+            std::vector<std::size_t> owners;
+        };
+        // Patched edges as (other node, owner) per node or as (from, to) per owner
+        typedef std::vector< std::pair<std::size_t, std::size_t> > DeltaEdges;
+        void ensureFactIndex(const UniqueId& relUid);
+        void collectConnections(const Hyperedges& ownerUids);
+        std::size_t connectivityNodeId(const UniqueId& uid);
+        void compileConnectivity();
+        void patchConnectivity(const Hyperedges& ownerUids);
+        void ensureConnectivity();
+        void traverse(const Hyperedges& uids, const TraversalDirection dir, const std::size_t maxHops, const UniqueId& targetUid,
+                      std::vector<std::size_t>& hops, std::vector<std::size_t>& parents);
+        bool connectivityValid;
+        std::set<UniqueId> connectivityPendingUids;
+        std::set<UniqueId> edgeRelationUids;
+        std::unordered_map<UniqueId, Connections> connectionsOf;
+        std::vector<UniqueId> connectivityNodes;
+        std::unordered_map<UniqueId, std::size_t> connectivityNodeIds;
+        Adjacency forwardAdjacency;
+        Adjacency inverseAdjacency;
+        std::vector<bool> staleOwners;
+        std::vector<DeltaEdges> forwardDelta;
+        std::vector<DeltaEdges> inverseDelta;
+        std::unordered_map<std::size_t, DeltaEdges> deltaEdgesOf;
+        std::size_t nDeltaEdges;
 };
 
 }
@@ -0,0 +1,62 @@
+#ifndef _DROCK_TRACE_HPP
+#define _DROCK_TRACE_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+
+// Tracing of Model operations as Chrome Trace Events (viewable in chrome://tracing or Perfetto)
+// NOTE: Only available if built with -DDROCK_TRACING=ON. Otherwise DROCK_TRACE_SCOPE expands to nothing.
+
+namespace Drock {
+namespace Trace {
+
+typedef std::vector< std::pair<std::string, std::string> > Arguments;
+
+#ifdef DROCK_TRACING
+
+// Start recording. The events are written to fileName on stop() or at exit.
+bool start(const std::string& fileName);
+bool stop();
+// True while recording
+bool enabled();
+
+// Returns the arguments given to DROCK_TRACE_SCOPE (if any)
+inline const Arguments& arguments(const Arguments& args, const Arguments& = Arguments()) { return args; }
+
+// Records the time between its construction and destruction
+class Span
+{
+    public:
+        Span(const char* name, const Arguments& args=Arguments());
+        ~Span();
+
+    private:
+        const char* name;
+        Arguments args;
+        long long begin;
+        bool active;
+};
+
+#else
+
+inline bool start(const std::string&) { return false; }
+inline bool stop() { return false; }
+
+#endif
+
+}
+}
+
+#ifdef DROCK_TRACING
+#define DROCK_TRACE_CONCAT_(a, b) a##b
+#define DROCK_TRACE_CONCAT(a, b) DROCK_TRACE_CONCAT_(a, b)
+// NOTE: The arguments are only built while recording
+#define DROCK_TRACE_SCOPE_(name, ...) Drock::Trace::Span DROCK_TRACE_CONCAT(drockTraceSpan, __LINE__)(name, \
+    Drock::Trace::enabled() ? Drock::Trace::Arguments(Drock::Trace::arguments(__VA_ARGS__)) : Drock::Trace::Arguments())
+#define DROCK_TRACE_SCOPE(...) DROCK_TRACE_SCOPE_(__VA_ARGS__, Drock::Trace::Arguments())
+#else
+#define DROCK_TRACE_SCOPE(...)
+#endif
+
+#endif
@@ -1,7 +1,17 @@
 #include "BasicModel.hpp"
+#include "HypergraphYAML.hpp"
+#include "Trace.hpp"
 #include <yaml-cpp/yaml.h>
 #include <iostream>
+#include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <functional>
+#include <tuple>
+#include <atomic>
+#include <cerrno>
+#include <thread>
+#include <sys/stat.h>
 
 // Import other domains
 #include "SoftwareGraph.hpp"
@@ -9,6 +19,35 @@
 
 namespace Drock {
 
+namespace {
+
+// Attributes all changes made during its lifetime to a single component (scopes may be nested)
+struct ChangeScope
+{
+    ChangeScope(UniqueId& target, const UniqueId& componentUid)
+    : scope(target), previous(target)
+    {
+        scope = componentUid;
+    }
+    ~ChangeScope()
+    {
+        scope = previous;
+    }
+    UniqueId& scope;
+    const UniqueId previous;
+};
+
+// Estimated memory used by a string: Short ones are stored inside the object (small string buffer), all others on the heap
+std::size_t stringBytes(const std::string& s)
+{
+    const char* object(reinterpret_cast<const char*>(&s));
+    const std::less<const char*> before = std::less<const char*>();
+    const bool isInline(!before(s.data(), object) && before(s.data(), object + sizeof(std::string)));
+    return sizeof(std::string) + (isInline ? 0 : s.capacity() + 1);
+}
+
+}
+
 const UniqueId Model::DomainId = "Drock::Model::Domain";
 const UniqueId Model::ComponentId = "Drock::Model::Component";
 const UniqueId Model::ComponentTypeId = "Drock::Model::Component::Type";
@@ -21,6 +60,7 @@ const UniqueId Model::HasConfigId = "Drock::Model::Relation::HasConfig";
 
 void Model::setupMetaModel()
 {
+    DROCK_TRACE_SCOPE("setupMetaModel");
     // Import meta models from other domains
     Software::Graph sg;
     Hardware::Computational::Network hcn;
@@ -57,12 +97,13 @@ void Model::setupMetaModel()
 }
 
 Model::Model()
+: indicesValid(false), deepTemplatesGeneration(0), generation(0), globalGeneration(0), coreShardLoaded(false), connectivityValid(false), nDeltaEdges(0)
 {
     setupMetaModel();
 }
 
 Model::Model(const Hypergraph& base)
-: Component::Network(base)
+: Component::Network(base), indicesValid(false), deepTemplatesGeneration(0), generation(0), globalGeneration(0), coreShardLoaded(false), connectivityValid(false), nDeltaEdges(0)
 {
     setupMetaModel();
 }
@@ -86,6 +127,471 @@ bool Model::inSoftwareDomain(const UniqueId& domainUid)
     return (domainUid == getDomainUid("SOFTWARE") ? true : false);
 }
 
+void Model::emit(YAML::Emitter& out, const Hyperedges& uids, const bool withRelations)
+{
+    for (const UniqueId& uid : uids)
+    {
+        out << YAML::BeginMap;
+        out << YAML::Key << "id" << YAML::Value << uid;
+        out << YAML::Key << "label" << YAML::Value << read(uid).label();
+        if (!withRelations)
+        {
+            out << YAML::EndMap;
+            continue;
+        }
+        Hyperedges fromUids(from(Hyperedges{uid}));
+        if (fromUids.size())
+        {
+            out << YAML::Key << "from" << YAML::Value << YAML::BeginSeq;
+            for (const UniqueId& fromUid : fromUids)
+                out << fromUid;
+            out << YAML::EndSeq;
+        }
+        Hyperedges toUids(to(Hyperedges{uid}));
+        if (toUids.size())
+        {
+            out << YAML::Key << "to" << YAML::Value << YAML::BeginSeq;
+            for (const UniqueId& toUid : toUids)
+                out << toUid;
+            out << YAML::EndSeq;
+        }
+        out << YAML::EndMap;
+    }
+}
+
+void Model::saveTo(std::ostream& out)
+{
+    DROCK_TRACE_SCOPE("saveTo");
+    // The emitter writes directly into the stream, only the current entity is kept in memory
+    YAML::Emitter emitter(out);
+    emitter << YAML::BeginSeq;
+    emit(emitter, find());
+    emitter << YAML::EndSeq;
+    out << std::endl;
+}
+
+bool Model::saveTo(const std::string& fileName, const std::size_t bufferSize)
+{
+    // NOTE: The buffer has to be set before opening the file and has to outlive the stream
+    std::vector<char> buffer(bufferSize);
+    std::ofstream fout;
+    if (buffer.size())
+        fout.rdbuf()->pubsetbuf(&buffer[0], buffer.size());
+    fout.open(fileName);
+    if (!fout.good())
+        return false;
+    saveTo(fout);
+    fout.close();
+    return !fout.fail();
+}
+
+Model::Footprints Model::footprintsOf(const Hyperedges& uids, const std::unordered_map<UniqueId, std::string>& categories)
+{
+    Footprints result;
+    for (const UniqueId& uid : uids)
+    {
+        // Entities which are neither part of a component nor a config are relations if they point from/to something
+        Hyperedges fromUids(from(Hyperedges{uid}));
+        Hyperedges toUids(to(Hyperedges{uid}));
+        std::unordered_map<UniqueId, std::string>::const_iterator it(categories.find(uid));
+        const std::string category(it != categories.end() ? it->second : (fromUids.size() || toUids.size() ? "relations" : "other"));
+        Footprint& footprint(result.insert(std::make_pair(category, Footprint())).first->second);
+        footprint.entities++;
+        // The UID is stored as key and as id of the entity
+        footprint.uidBytes += 2 * stringBytes(uid);
+        footprint.labelBytes += stringBytes(read(uid).label());
+        for (const UniqueId& fromUid : fromUids)
+            footprint.referenceBytes += stringBytes(fromUid);
+        for (const UniqueId& toUid : toUids)
+            footprint.referenceBytes += stringBytes(toUid);
+        // Tree node of the entity and its containers of references
+        footprint.overheadBytes += 4 * sizeof(void*) + 2 * sizeof(Hyperedges);
+    }
+    return result;
+}
+
+void Model::emitFootprints(YAML::Emitter& out, const Footprints& footprints)
+{
+    Footprint total = Footprint();
+    out << YAML::BeginMap;
+    out << YAML::Key << "categories" << YAML::Value << YAML::BeginMap;
+    for (const auto& entry : footprints)
+    {
+        const Footprint& footprint(entry.second);
+        out << YAML::Key << entry.first << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "entities" << YAML::Value << footprint.entities;
+        out << YAML::Key << "uidBytes" << YAML::Value << footprint.uidBytes;
+        out << YAML::Key << "labelBytes" << YAML::Value << footprint.labelBytes;
+        out << YAML::Key << "referenceBytes" << YAML::Value << footprint.referenceBytes;
+        out << YAML::Key << "overheadBytes" << YAML::Value << footprint.overheadBytes;
+        out << YAML::Key << "bytes" << YAML::Value << (footprint.uidBytes + footprint.labelBytes + footprint.referenceBytes + footprint.overheadBytes);
+        out << YAML::EndMap;
+        total.entities += footprint.entities;
+        total.uidBytes += footprint.uidBytes;
+        total.labelBytes += footprint.labelBytes;
+        total.referenceBytes += footprint.referenceBytes;
+        total.overheadBytes += footprint.overheadBytes;
+    }
+    out << YAML::EndMap;
+    out << YAML::Key << "entities" << YAML::Value << total.entities;
+    out << YAML::Key << "uidBytes" << YAML::Value << total.uidBytes;
+    out << YAML::Key << "labelBytes" << YAML::Value << total.labelBytes;
+    out << YAML::Key << "referenceBytes" << YAML::Value << total.referenceBytes;
+    out << YAML::Key << "overheadBytes" << YAML::Value << total.overheadBytes;
+    out << YAML::Key << "bytes" << YAML::Value << (total.uidBytes + total.labelBytes + total.referenceBytes + total.overheadBytes);
+    out << YAML::EndMap;
+}
+
+void Model::reportMemory(std::ostream& out)
+{
+    DROCK_TRACE_SCOPE("reportMemory");
+    // Categorize all components, their versions, their instances (parts), interfaces and configs
+    ensureIndices();
+    std::vector<UniqueId> componentUids;
+    for (const auto& entry : versionIndex)
+    {
+        componentUids.push_back(entry.first);
+        componentUids.insert(componentUids.end(), entry.second.begin(), entry.second.end());
+    }
+    Hyperedges modelUids(unite(Hyperedges(), Hyperedges(componentUids.begin(), componentUids.end())));
+    Hyperedges partUids(subtract(instancesOf(modelUids), modelUids));
+    Hyperedges interfaceUids(interfacesOf(unite(modelUids, partUids)));
+    Hyperedges configUids(to(factsOf(Hyperedges{Model::HasConfigId})));
+    std::unordered_map<UniqueId, std::string> categories;
+    for (const UniqueId& uid : modelUids)
+        categories[uid] = "components";
+    for (const UniqueId& uid : partUids)
+        categories[uid] = "parts";
+    for (const UniqueId& uid : interfaceUids)
+        categories[uid] = "interfaces";
+    for (const UniqueId& uid : configUids)
+        categories[uid] = "configs";
+
+    YAML::Emitter emitter(out);
+    emitter << YAML::BeginMap;
+    emitter << YAML::Key << "total" << YAML::Value;
+    emitFootprints(emitter, footprintsOf(find(), categories));
+    // Break down by the entities belonging to the components of each domain and type
+    const Index* indices[2] = {&domainIndex, &typeIndex};
+    const char* keys[2] = {"domains", "types"};
+    for (std::size_t i = 0; i < 2; i++)
+    {
+        std::map<std::string, UniqueId> labelledUids;
+        for (const auto& entry : *indices[i])
+        {
+            if (entry.second.size())
+                labelledUids[read(entry.first).label()] = entry.first;
+        }
+        emitter << YAML::Key << keys[i] << YAML::Value << YAML::BeginMap;
+        for (const auto& entry : labelledUids)
+        {
+            emitter << YAML::Key << entry.first << YAML::Value;
+            emitFootprints(emitter, footprintsOf(entitiesOf(lookup(*indices[i], entry.second)), categories));
+        }
+        emitter << YAML::EndMap;
+    }
+    emitter << YAML::EndMap;
+    out << std::endl;
+}
+
+bool Model::reportMemory(const std::string& fileName)
+{
+    std::ofstream fout;
+    fout.open(fileName);
+    if (!fout.good())
+        return false;
+    reportMemory(fout);
+    fout.close();
+    return !fout.fail();
+}
+
+std::string Model::domainOf(const UniqueId& componentUid)
+{
+    // Component UIDs are <ComponentId>::<domain>::<name>(::<version>), see getComponentUid
+    const std::string prefix(Model::ComponentId+"::");
+    if (componentUid.compare(0, prefix.size(), prefix) || !componentUid.compare(0, Model::ComponentTypeId.size(), Model::ComponentTypeId))
+        return std::string();
+    const std::size_t end(componentUid.find("::", prefix.size()));
+    return componentUid.substr(prefix.size(), end == std::string::npos ? std::string::npos : end - prefix.size());
+}
+
+Hyperedges Model::entitiesOf(const Hyperedges& componentUids)
+{
+    // The components, their versions, the parts of these versions and all their interfaces
+    Hyperedges versionUids;
+    for (const UniqueId& componentUid : componentUids)
+        versionUids = unite(versionUids, versionsOf(componentUid));
+    Hyperedges ownerUids(unite(unite(componentUids, versionUids), componentsOf(versionUids)));
+    Hyperedges entityUids(unite(ownerUids, interfacesOf(ownerUids)));
+
+    // Follow all relations starting at them and configs attached to them (and to these relations and configs etc.)
+    // NOTE: Relations belong to their source only. A relation ending here, e.g. an instance of this component being
+    // part of another domain, belongs to the other domain and makes it depend on this one (see saveShards).
+    std::set<UniqueId> result(entityUids.begin(), entityUids.end());
+    Hyperedges frontierUids(entityUids);
+    while (frontierUids.size())
+    {
+        Hyperedges nextUids(unite(relationsFrom(frontierUids), configsOf(frontierUids)));
+        std::vector<UniqueId> newUids;
+        for (const UniqueId& nextUid : nextUids)
+        {
+            if (result.insert(nextUid).second)
+                newUids.push_back(nextUid);
+        }
+        frontierUids = Hyperedges(newUids.begin(), newUids.end());
+    }
+    return Hyperedges(result.begin(), result.end());
+}
+
+bool Model::writeShard(const std::string& fileName, const Hyperedges& uids, Hyperedges& stubUids)
+{
+    // Entities referenced but stored in other shards are written as stubs (id and label only)
+    std::set<UniqueId> members(uids.begin(), uids.end());
+    std::set<UniqueId> stubs;
+    for (const UniqueId& uid : uids)
+    {
+        Hyperedges otherUids(unite(from(Hyperedges{uid}), to(Hyperedges{uid})));
+        for (const UniqueId& otherUid : otherUids)
+        {
+            if (!members.count(otherUid))
+                stubs.insert(otherUid);
+        }
+    }
+    stubUids = Hyperedges(stubs.begin(), stubs.end());
+
+    std::vector<char> buffer(16 << 20);
+    std::ofstream fout;
+    fout.rdbuf()->pubsetbuf(&buffer[0], buffer.size());
+    fout.open(fileName);
+    if (!fout.good())
+        return false;
+    YAML::Emitter out(fout);
+    out << YAML::BeginMap;
+    out << YAML::Key << "entities" << YAML::Value << YAML::BeginSeq;
+    emit(out, uids);
+    out << YAML::EndSeq;
+    out << YAML::Key << "stubs" << YAML::Value << YAML::BeginSeq;
+    emit(out, stubUids, false);
+    out << YAML::EndSeq;
+    out << YAML::EndMap;
+    fout << std::endl;
+    fout.close();
+    return !fout.fail();
+}
+
+bool Model::saveShards(const std::string& directory, const std::vector<std::string>& domains)
+{
+    DROCK_TRACE_SCOPE("saveShards", {{"directory", directory}});
+    if (mkdir(directory.c_str(), 0755) && (errno != EEXIST))
+        return false;
+    const std::string manifestFileName(directory+"/shards.yml");
+    YAML::Node manifest;
+    std::ifstream fin(manifestFileName);
+    if (fin.good())
+        manifest = YAML::Load(fin);
+    fin.close();
+
+    // Assign every entity to (at most) one domain. Domains are handled in a fixed order, first come first serve.
+    ensureIndices();
+    std::map<std::string, UniqueId> domainUids;
+    for (const auto& entry : domainIndex)
+        domainUids[read(entry.first).label()] = entry.first;
+    std::unordered_map<UniqueId, std::string> owners;
+    std::map<std::string, Hyperedges> shardUids;
+    for (const auto& entry : domainUids)
+    {
+        std::vector<UniqueId> claimedUids;
+        Hyperedges entityUids(entitiesOf(componentsOfDomain(entry.second)));
+        for (const UniqueId& entityUid : entityUids)
+        {
+            if (owners.count(entityUid))
+                continue;
+            owners[entityUid] = entry.first;
+            claimedUids.push_back(entityUid);
+        }
+        shardUids[entry.first] = Hyperedges(claimedUids.begin(), claimedUids.end());
+    }
+    // Everything else (meta model, domains, types, interface and relation classes) belongs to the core
+    // NOTE: Stubs of shards which have not been loaded must not end up in the core
+    std::vector<UniqueId> coreUids;
+    Hyperedges allUids(find());
+    for (const UniqueId& uid : allUids)
+    {
+        if (!owners.count(uid) && !shardStubUids.count(uid))
+            coreUids.push_back(uid);
+    }
+
+    // By default, store all non-empty domains
+    std::vector<std::string> domainsToStore(domains);
+    if (domainsToStore.empty())
+    {
+        for (const auto& entry : shardUids)
+        {
+            if (entry.second.size())
+                domainsToStore.push_back(entry.first);
+        }
+    }
+
+    bool ok = true;
+    YAML::Node domainsYAML(manifest["domains"]);
+    for (const std::string& domain : domainsToStore)
+    {
+        // Never overwrite a shard we do not know the contents of
+        if (coreShardLoaded && domainsYAML[domain].IsDefined() && !loadedShards.count(domain))
+        {
+            std::cout << "Shard " << domain << " has not been loaded. Skipping\n";
+            continue;
+        }
+        Hyperedges stubUids;
+        const std::string fileName(domain+".yml");
+        if (!writeShard(directory+"/"+fileName, shardUids[domain], stubUids))
+        {
+            std::cout << "Cannot write shard " << fileName << "\n";
+            ok = false;
+            continue;
+        }
+        // Remember which other shards are referenced by stubs
+        std::set<std::string> dependencies;
+        for (const UniqueId& stubUid : stubUids)
+        {
+            std::unordered_map<UniqueId, std::string>::const_iterator it(owners.find(stubUid));
+            if (it != owners.end())
+                dependencies.insert(it->second);
+            else if (shardStubUids.count(stubUid) && !domainOf(stubUid).empty())
+                dependencies.insert(domainOf(stubUid));
+        }
+        // Stubs of shards which have not been loaded cannot be resolved, so keep what we knew before
+        if (coreShardLoaded && domainsYAML[domain]["dependencies"].IsDefined())
+        {
+            const YAML::Node& previous(domainsYAML[domain]["dependencies"]);
+            for (auto it = previous.begin(); it != previous.end(); it++)
+                dependencies.insert(it->as<std::string>());
+        }
+        dependencies.erase(domain);
+        YAML::Node shardYAML;
+        shardYAML["file"] = fileName;
+        for (const std::string& dependency : dependencies)
+            shardYAML["dependencies"].push_back(dependency);
+        domainsYAML[domain] = shardYAML;
+    }
+
+    Hyperedges coreStubUids;
+    if (!writeShard(directory+"/core.yml", Hyperedges(coreUids.begin(), coreUids.end()), coreStubUids))
+    {
+        std::cout << "Cannot write core shard\n";
+        return false;
+    }
+    manifest["core"] = "core.yml";
+
+    std::ofstream fout;
+    fout.open(manifestFileName);
+    if (!fout.good())
+        return false;
+    fout << manifest << std::endl;
+    fout.close();
+    return ok;
+}
+
+bool Model::loadShards(const std::string& directory, const std::vector<std::string>& domains, const bool withDependencies)
+{
+    DROCK_TRACE_SCOPE("loadShards", {{"directory", directory}});
+    const std::string manifestFileName(directory+"/shards.yml");
+    std::ifstream fin(manifestFileName);
+    if (!fin.good())
+        return false;
+    // NOTE: A broken manifest or shard fails the whole load. Shards merged before the failure stay in the model
+    std::set<std::string> domainsToLoad;
+    try {
+        YAML::Node manifest(YAML::Load(fin));
+        fin.close();
+
+        // Resolve the shards to be loaded (and the ones they depend on)
+        std::vector<std::string> fileNames;
+        if (!coreShardLoaded)
+            fileNames.push_back(manifest["core"].as<std::string>());
+        std::vector<std::string> queue(domains);
+        while (!queue.empty())
+        {
+            const std::string domain(queue.back());
+            queue.pop_back();
+            if (loadedShards.count(domain) || domainsToLoad.count(domain))
+                continue;
+            // NOTE: Unknown domains are fine, they might be created by subsequent imports
+            const YAML::Node& shardYAML(manifest["domains"][domain]);
+            if (!shardYAML.IsDefined())
+                continue;
+            domainsToLoad.insert(domain);
+            fileNames.push_back(shardYAML["file"].as<std::string>());
+            if (!withDependencies || !shardYAML["dependencies"].IsDefined())
+                continue;
+            const YAML::Node& dependencies(shardYAML["dependencies"]);
+            for (auto it = dependencies.begin(); it != dependencies.end(); it++)
+                queue.push_back(it->as<std::string>());
+        }
+
+        for (const std::string& fileName : fileNames)
+        {
+            DROCK_TRACE_SCOPE("loadShard", {{"file", fileName}});
+            YAML::Node shard(YAML::LoadFile(directory+"/"+fileName));
+            YAML::Node graph;
+            const YAML::Node& entities(shard["entities"]);
+            for (auto it = entities.begin(); it != entities.end(); it++)
+            {
+                shardStubUids.erase((*it)["id"].as<std::string>());
+                graph.push_back(*it);
+            }
+            const YAML::Node& stubs(shard["stubs"]);
+            for (auto it = stubs.begin(); it != stubs.end(); it++)
+            {
+                // A stub refers to an entity of another shard, unless that one has been loaded already
+                const UniqueId stubUid((*it)["id"].as<std::string>());
+                if (!exists(stubUid))
+                    shardStubUids.insert(stubUid);
+                graph.push_back(*it);
+            }
+            merge(graph.as<Hypergraph>());
+        }
+    } catch (const YAML::Exception& e) {
+        std::cout << "Cannot load shards from " << directory << ": " << e.what() << "\n";
+        return false;
+    }
+    coreShardLoaded = true;
+    loadedShards.insert(domainsToLoad.begin(), domainsToLoad.end());
+    return true;
+}
+
+Hyperedges Model::merge(const Hypergraph& other)
+{
+    DROCK_TRACE_SCOPE("merge");
+    // NOTE: The meta model has been set up already. Entities with known UIDs (e.g. the ones of the meta model) are merged by importFrom
+    Hyperedges result(importFrom(other));
+    invalidate();
+    return result;
+}
+
+void Model::invalidate(const UniqueId& componentUid)
+{
+    // Unknown changes: all derived indices have to be rebuilt (lazily)
+    indicesValid = false;
+    factsFromIndex.clear();
+    factsToIndex.clear();
+    if (!componentUid.empty())
+        connectivityPendingUids.insert(componentUid);
+    changed(componentUid);
+}
+
+void Model::changed(const UniqueId& componentUid)
+{
+    generation++;
+    if (componentUid.empty())
+    {
+        globalGeneration = generation;
+        connectivityValid = false;
+    }
+    else
+        componentGenerations[componentUid] = generation;
+}
+
 UniqueId Model::getDomainUid(const std::string& domain)
 {
     return Model::DomainId+"::"+domain;
@@ -125,6 +631,8 @@ UniqueId Model::getInterfaceUid(const std::string& type, const std::string& dire
 
 Hyperedges Model::instantiateConfigOnce(const Hyperedges& parentUids, const std::string& label)
 {
+    DROCK_TRACE_SCOPE("instantiateConfigOnce");
+    changed(changingComponentUid);
     Hyperedges result;
     // Restriction: Allow only one config per parent
     for (const UniqueId& parentUid : parentUids)
@@ -149,6 +657,7 @@ Hyperedges Model::instantiateConfigOnce(const Hyperedges& parentUids, const std:
 
 Hyperedges Model::hasConfig(const Hyperedges& parentUids, const Hyperedges& childrenUids)
 {
+    changed(changingComponentUid);
     Hyperedges result;
     for (const UniqueId& parentId : parentUids)
     {
@@ -157,20 +666,842 @@ Hyperedges Model::hasConfig(const Hyperedges& parentUids, const Hyperedges& chil
             result = unite(result, factFrom(Hyperedges{parentId}, Hyperedges{childId}, Model::HasConfigId));
         }
     }
+    indexFacts(Model::HasConfigId, result);
     return result;
 }
 
 Hyperedges Model::configsOf(const Hyperedges& uids, const std::string& label)
 {
     // TODO: Handle query direction!
-    Hyperedges myChildren(childrenOf(uids, label));
-    Hyperedges allConfigs(to(factsOf(Hyperedges{Model::HasConfigId}), label));
-    return intersect(myChildren, allConfigs);
+    // Only the HasConfig facts starting at uids are considered (see factsBetween)
+    ensureFactIndex(Model::HasConfigId);
+    const Index& byFrom(factsFromIndex[Model::HasConfigId]);
+    std::vector<UniqueId> factUids;
+    for (const UniqueId& uid : uids)
+    {
+        Index::const_iterator it(byFrom.find(uid));
+        if (it != byFrom.end())
+            factUids.insert(factUids.end(), it->second.begin(), it->second.end());
+    }
+    if (factUids.empty())
+        return Hyperedges();
+    return to(unite(Hyperedges(), Hyperedges(factUids.begin(), factUids.end())), label);
+}
+
+void Model::rebuildIndices()
+{
+    DROCK_TRACE_SCOPE("rebuildIndices");
+    domainIndex.clear();
+    typeIndex.clear();
+    versionIndex.clear();
+
+    // Components are direct subclasses of both their domain and their type, versions are direct subclasses of components
+    Hyperedges domainUids(directSubclassesOf(Hyperedges{Model::DomainId}));
+    for (const UniqueId& domainUid : domainUids)
+    {
+        Hyperedges componentUids(directSubclassesOf(Hyperedges{domainUid}));
+        domainIndex[domainUid].insert(componentUids.begin(), componentUids.end());
+    }
+    Hyperedges typeUids(directSubclassesOf(Hyperedges{Model::ComponentTypeId}));
+    for (const UniqueId& typeUid : typeUids)
+    {
+        Hyperedges componentUids(directSubclassesOf(Hyperedges{typeUid}));
+        typeIndex[typeUid].insert(componentUids.begin(), componentUids.end());
+        for (const UniqueId& componentUid : componentUids)
+        {
+            Hyperedges versionUids(directSubclassesOf(Hyperedges{componentUid}));
+            versionIndex[componentUid].insert(versionUids.begin(), versionUids.end());
+        }
+    }
+    indicesValid = true;
+}
+
+void Model::ensureIndices()
+{
+    if (!indicesValid)
+        rebuildIndices();
+}
+
+void Model::indexFacts(const UniqueId& relUid, const Hyperedges& factUids)
+{
+    // If the facts of relUid have not been indexed yet, they will be when queried the first time
+    FactIndex::iterator fit(factsFromIndex.find(relUid));
+    FactIndex::iterator tit(factsToIndex.find(relUid));
+    if ((fit == factsFromIndex.end()) || (tit == factsToIndex.end()))
+        return;
+    for (const UniqueId& factUid : factUids)
+    {
+        Hyperedges fromUids(from(Hyperedges{factUid}));
+        for (const UniqueId& fromUid : fromUids)
+            fit->second[fromUid].insert(factUid);
+        Hyperedges toUids(to(Hyperedges{factUid}));
+        for (const UniqueId& toUid : toUids)
+            tit->second[toUid].insert(factUid);
+    }
+}
+
+void Model::ensureFactIndex(const UniqueId& relUid)
+{
+    if (factsFromIndex.count(relUid) && factsToIndex.count(relUid))
+        return;
+    // First query for relUid: index all of its facts once
+    factsFromIndex[relUid];
+    factsToIndex[relUid];
+    DROCK_TRACE_SCOPE("factsOf", {{"relation", relUid}});
+    indexFacts(relUid, factsOf(relUid));
+}
+
+Hyperedges Model::factsBetween(const UniqueId& relUid, const Hyperedges& fromUids, const Hyperedges& toUids, const std::string& label)
+{
+    ensureFactIndex(relUid);
+    const Index& byFrom(factsFromIndex[relUid]);
+    const Index& byTo(factsToIndex[relUid]);
+    std::vector<UniqueId> result;
+    for (const UniqueId& fromUid : fromUids)
+    {
+        Index::const_iterator fit(byFrom.find(fromUid));
+        if (fit == byFrom.end())
+            continue;
+        for (const UniqueId& toUid : toUids)
+        {
+            Index::const_iterator tit(byTo.find(toUid));
+            if (tit == byTo.end())
+                continue;
+            // Walk the smaller set and look up the larger one
+            const std::set<UniqueId>& smaller(fit->second.size() < tit->second.size() ? fit->second : tit->second);
+            const std::set<UniqueId>& larger(fit->second.size() < tit->second.size() ? tit->second : fit->second);
+            for (const UniqueId& factUid : smaller)
+            {
+                if (!larger.count(factUid))
+                    continue;
+                if (!label.empty() && (read(factUid).label() != label))
+                    continue;
+                result.push_back(factUid);
+            }
+        }
+    }
+    return unite(Hyperedges(), Hyperedges(result.begin(), result.end()));
+}
+
+Hyperedges Model::lookup(const Index& index, const UniqueId& key)
+{
+    Index::const_iterator it(index.find(key));
+    if (it == index.end())
+        return Hyperedges();
+    return Hyperedges(it->second.begin(), it->second.end());
+}
+
+Hyperedges Model::componentsOfDomain(const UniqueId& domainUid)
+{
+    ensureIndices();
+    return lookup(domainIndex, domainUid);
+}
+
+Hyperedges Model::componentsOfType(const UniqueId& typeUid)
+{
+    ensureIndices();
+    return lookup(typeIndex, typeUid);
+}
+
+Hyperedges Model::componentsOfDomainAndType(const UniqueId& domainUid, const UniqueId& typeUid)
+{
+    ensureIndices();
+    Index::const_iterator dit(domainIndex.find(domainUid));
+    Index::const_iterator tit(typeIndex.find(typeUid));
+    if ((dit == domainIndex.end()) || (tit == typeIndex.end()))
+        return Hyperedges();
+    // Walk the smaller set and look up the larger one
+    const std::set<UniqueId>& smaller(dit->second.size() < tit->second.size() ? dit->second : tit->second);
+    const std::set<UniqueId>& larger(dit->second.size() < tit->second.size() ? tit->second : dit->second);
+    std::vector<UniqueId> result;
+    for (const UniqueId& componentUid : smaller)
+    {
+        if (larger.count(componentUid))
+            result.push_back(componentUid);
+    }
+    return Hyperedges(result.begin(), result.end());
+}
+
+Hyperedges Model::versionsOf(const UniqueId& componentUid)
+{
+    ensureIndices();
+    return lookup(versionIndex, componentUid);
+}
+
+const Model::DeepTemplate& Model::deepTemplateOf(const UniqueId& modelUid)
+{
+    DROCK_TRACE_SCOPE("deepTemplateOf", {{"version", modelUid}});
+    std::map<UniqueId, DeepTemplate>::const_iterator it(deepTemplates.find(modelUid));
+    if (it != deepTemplates.end())
+        return it->second;
+
+    // Not yet known: Query the parts of the model and their interconnections once
+    DeepTemplate& result(deepTemplates[modelUid]);
+    std::map<UniqueId, std::size_t> partIndices;
+    Hyperedges partUids(componentsOf(Hyperedges{modelUid}));
+    for (const UniqueId& partUid : partUids)
+    {
+        // the direct superclass of a part is the model version it has been instantiated from
+        Hyperedges partModelUids(instancesOf(Hyperedges{partUid}, "", TraversalDirection::FORWARD));
+        if (!partModelUids.size())
+            continue;
+        DeepTemplate::Part part;
+        part.modelUid = *partModelUids.begin();
+        part.label = read(partUid).label();
+        Hyperedges configUids(configsOf(Hyperedges{partUid}));
+        for (const UniqueId& configUid : configUids)
+            part.configs.push_back(read(configUid).label());
+        partIndices[partUid] = result.parts.size();
+        result.parts.push_back(part);
+    }
+
+    // For every pair of parts, we have to remember the relations and interconnections as well.
+    for (const auto& fromPart : partIndices)
+    {
+        Hyperedges relsFromUids(relationsFrom(Hyperedges{fromPart.first}));
+        Hyperedges fromInterfaceUids(interfacesOf(Hyperedges{fromPart.first}));
+        for (const auto& toPart : partIndices)
+        {
+            // First: all normal relations
+            Hyperedges commonRelUids(intersect(relsFromUids, relationsTo(Hyperedges{toPart.first})));
+            for (const UniqueId& commonUid : commonRelUids)
+            {
+                Hyperedges edgeTypeUids(factsOf(Hyperedges{commonUid}, "", TraversalDirection::FORWARD));
+                if (!edgeTypeUids.size())
+                    continue;
+                DeepTemplate::Edge edge;
+                edge.from = fromPart.second;
+                edge.to = toPart.second;
+                edge.relUid = *edgeTypeUids.begin();
+                edge.label = read(commonUid).label();
+                Hyperedges configUids(configsOf(Hyperedges{commonUid}));
+                for (const UniqueId& configUid : configUids)
+                    edge.configs.push_back(read(configUid).label());
+                result.edges.push_back(edge);
+            }
+            // Second: all connect relations between interfaces
+            Hyperedges toInterfaceUids(interfacesOf(Hyperedges{toPart.first}));
+            for (const UniqueId& fromInterfaceUid : fromInterfaceUids)
+            {
+                Hyperedges relsFromInterfaceUids(relationsFrom(Hyperedges{fromInterfaceUid}));
+                for (const UniqueId& toInterfaceUid : toInterfaceUids)
+                {
+                    Hyperedges commonInterfaceRelUids(intersect(relsFromInterfaceUids, relationsTo(Hyperedges{toInterfaceUid})));
+                    for (const UniqueId& commonUid : commonInterfaceRelUids)
+                    {
+                        DeepTemplate::Edge edge;
+                        edge.from = fromPart.second;
+                        edge.to = toPart.second;
+                        edge.fromInterface = read(fromInterfaceUid).label();
+                        edge.toInterface = read(toInterfaceUid).label();
+                        edge.label = read(commonUid).label();
+                        Hyperedges configUids(configsOf(Hyperedges{commonUid}));
+                        for (const UniqueId& configUid : configUids)
+                            edge.configs.push_back(read(configUid).label());
+                        result.edges.push_back(edge);
+                    }
+                }
+            }
+        }
+    }
+
+    // Finally: the interfaces of the model which are aliases of interfaces of its parts
+    Hyperedges interfaceUids(interfacesOf(Hyperedges{modelUid}));
+    for (const UniqueId& interfaceUid : interfaceUids)
+    {
+        Hyperedges originalUids(originalInterfacesOf(Hyperedges{interfaceUid}));
+        for (const UniqueId& originalUid : originalUids)
+        {
+            Hyperedges ownerUids(interfacesOf(Hyperedges{originalUid}, "", TraversalDirection::INVERSE));
+            for (const UniqueId& ownerUid : ownerUids)
+            {
+                std::map<UniqueId, std::size_t>::const_iterator pit(partIndices.find(ownerUid));
+                if (pit == partIndices.end())
+                    continue;
+                DeepTemplate::Alias alias;
+                alias.label = read(interfaceUid).label();
+                alias.part = pit->second;
+                alias.originalLabel = read(originalUid).label();
+                result.aliases.push_back(alias);
+            }
+        }
+    }
+    return result;
+}
+
+Hyperedges Model::instantiateDeepFrom(const UniqueId& modelUid, const std::string& label, Hyperedges& expandingUids)
+{
+    DROCK_TRACE_SCOPE("instantiateDeepFrom", {{"version", modelUid}, {"label", label}});
+    // Guard against models which (indirectly) contain themselves
+    if (intersect(expandingUids, Hyperedges{modelUid}).size())
+    {
+        std::cout << "Model " << modelUid << " contains itself. Stop expanding\n";
+        return Hyperedges();
+    }
+    Hyperedges instanceUids(instantiateComponent(Hyperedges{modelUid}, label));
+    if (!instanceUids.size())
+        return instanceUids;
+    // All further changes belong to the new instance. Instances are not part of any exported component,
+    // but they (and their connections) have to be added to the connectivity index
+    ChangeScope scope(changingComponentUid, *instanceUids.begin());
+    changed(*instanceUids.begin());
+    connectivityPendingUids.insert(instanceUids.begin(), instanceUids.end());
+
+    // NOTE: References into deepTemplates stay valid while other templates get added
+    const DeepTemplate& tmpl(deepTemplateOf(modelUid));
+    expandingUids = unite(expandingUids, Hyperedges{modelUid});
+    std::vector<UniqueId> partUids;
+    for (const DeepTemplate::Part& part : tmpl.parts)
+    {
+        Hyperedges newPartUids(instantiateDeepFrom(part.modelUid, part.label, expandingUids));
+        partUids.push_back(newPartUids.size() ? *newPartUids.begin() : UniqueId());
+        if (!newPartUids.size())
+            continue;
+        partOf(newPartUids, instanceUids);
+        for (const std::string& config : part.configs)
+            instantiateConfigOnce(newPartUids, config);
+    }
+    for (const DeepTemplate::Edge& edge : tmpl.edges)
+    {
+        if (partUids[edge.from].empty() || partUids[edge.to].empty())
+            continue;
+        Hyperedges newEdgeUids;
+        if (!edge.relUid.empty())
+        {
+            newEdgeUids = factFrom(Hyperedges{partUids[edge.from]}, Hyperedges{partUids[edge.to]}, Hyperedges{edge.relUid});
+            indexFacts(edge.relUid, newEdgeUids);
+        } else {
+            Hyperedges fromInterfaceUids(interfacesOf(Hyperedges{partUids[edge.from]}, edge.fromInterface));
+            Hyperedges toInterfaceUids(interfacesOf(Hyperedges{partUids[edge.to]}, edge.toInterface));
+            newEdgeUids = connectInterface(fromInterfaceUids, toInterfaceUids);
+            indexFacts(Component::Network::ConnectedToInterfaceId, newEdgeUids);
+        }
+        for (const UniqueId& newEdgeUid : newEdgeUids)
+            get(newEdgeUid).updateLabel(edge.label);
+        for (const std::string& config : edge.configs)
+            instantiateConfigOnce(newEdgeUids, config);
+    }
+    // The interfaces of the new instance have to lead to the ones of its new parts
+    for (const DeepTemplate::Alias& alias : tmpl.aliases)
+    {
+        if (partUids[alias.part].empty())
+            continue;
+        Hyperedges aliasUids(interfacesOf(instanceUids, alias.label));
+        Hyperedges originalUids(interfacesOf(Hyperedges{partUids[alias.part]}, alias.originalLabel));
+        if (aliasUids.size() && originalUids.size())
+            aliasOf(aliasUids, originalUids);
+    }
+    expandingUids = subtract(expandingUids, Hyperedges{modelUid});
+    return instanceUids;
+}
+
+Hyperedges Model::instantiateDeepFrom(const Hyperedges& modelUids, const std::string& label)
+{
+    // Drop memoized model structures if anything changed since they have been queried
+    if (deepTemplatesGeneration != generation)
+        deepTemplates.clear();
+    Hyperedges result;
+    for (const UniqueId& modelUid : modelUids)
+    {
+        if (!exists(modelUid))
+        {
+            std::cout << "Cannot find model " << modelUid << "\n";
+            continue;
+        }
+        Hyperedges expandingUids;
+        result = unite(result, instantiateDeepFrom(modelUid, label, expandingUids));
+    }
+    // Only new instances have been created (and configured), the models themselves did not change
+    deepTemplatesGeneration = generation;
+    return result;
+}
+
+void Model::collectConnections(const Hyperedges& ownerUids)
+{
+    DROCK_TRACE_SCOPE("collectConnections", {{"owners", std::to_string(ownerUids.size())}});
+    ensureFactIndex(Component::Network::ConnectedToInterfaceId);
+    for (const UniqueId& relUid : edgeRelationUids)
+        ensureFactIndex(relUid);
+    const Index& connectionsFrom(factsFromIndex[Component::Network::ConnectedToInterfaceId]);
+
+    for (const UniqueId& ownerUid : ownerUids)
+    {
+        Connections& connections(connectionsOf[ownerUid]);
+        connections.clear();
+        // Typed edges start at the owner itself
+        for (const UniqueId& relUid : edgeRelationUids)
+        {
+            const Index& byFrom(factsFromIndex[relUid]);
+            Index::const_iterator fit(byFrom.find(ownerUid));
+            if (fit == byFrom.end())
+                continue;
+            Hyperedges toUids(to(Hyperedges(fit->second.begin(), fit->second.end())));
+            for (const UniqueId& toUid : toUids)
+                connections.push_back(std::make_pair(ownerUid, toUid));
+        }
+        // Interface connections start at one of its interfaces, alias interfaces lead to the part owning the original one
+        Hyperedges interfaceUids(interfacesOf(Hyperedges{ownerUid}));
+        for (const UniqueId& interfaceUid : interfaceUids)
+        {
+            Index::const_iterator cit(connectionsFrom.find(interfaceUid));
+            if (cit != connectionsFrom.end())
+            {
+                Hyperedges otherUids(interfacesOf(to(Hyperedges(cit->second.begin(), cit->second.end())), "", TraversalDirection::INVERSE));
+                for (const UniqueId& otherUid : otherUids)
+                    connections.push_back(std::make_pair(ownerUid, otherUid));
+            }
+            Hyperedges partUids(interfacesOf(originalInterfacesOf(Hyperedges{interfaceUid}), "", TraversalDirection::INVERSE));
+            for (const UniqueId& partUid : partUids)
+            {
+                connections.push_back(std::make_pair(ownerUid, partUid));
+                connections.push_back(std::make_pair(partUid, ownerUid));
+            }
+        }
+        if (connections.empty())
+            connectionsOf.erase(ownerUid);
+    }
+}
+
+std::size_t Model::connectivityNodeId(const UniqueId& uid)
+{
+    std::unordered_map<UniqueId, std::size_t>::const_iterator it(connectivityNodeIds.find(uid));
+    if (it != connectivityNodeIds.end())
+        return it->second;
+    connectivityNodeIds[uid] = connectivityNodes.size();
+    connectivityNodes.push_back(uid);
+    forwardDelta.resize(connectivityNodes.size());
+    inverseDelta.resize(connectivityNodes.size());
+    return connectivityNodes.size() - 1;
+}
+
+void Model::compileConnectivity()
+{
+    DROCK_TRACE_SCOPE("compileConnectivity");
+    // Compiles all connections from scratch, dropping the patches (see patchConnectivity)
+    connectivityNodes.clear();
+    connectivityNodeIds.clear();
+    forwardDelta.clear();
+    inverseDelta.clear();
+    deltaEdgesOf.clear();
+    nDeltaEdges = 0;
+    // Every edge remembers the owner it has been derived from, so its edges can be masked once the owner changes
+    std::vector< std::tuple<std::size_t, std::size_t, std::size_t> > edges;
+    for (const auto& entry : connectionsOf)
+    {
+        const std::size_t ownerId(connectivityNodeId(entry.first));
+        for (const auto& connection : entry.second)
+        {
+            const std::size_t fromId(connectivityNodeId(connection.first));
+            const std::size_t toId(connectivityNodeId(connection.second));
+            if (fromId != toId)
+                edges.push_back(std::make_tuple(fromId, toId, ownerId));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    staleOwners.assign(connectivityNodes.size(), false);
+
+    // Counting sort of the edges by source (forward) and by target (inverse)
+    const std::size_t n(connectivityNodes.size());
+    forwardAdjacency.offsets.assign(n + 1, 0);
+    inverseAdjacency.offsets.assign(n + 1, 0);
+    for (const auto& edge : edges)
+    {
+        forwardAdjacency.offsets[std::get<0>(edge) + 1]++;
+        inverseAdjacency.offsets[std::get<1>(edge) + 1]++;
+    }
+    for (std::size_t i = 0; i < n; i++)
+    {
+        forwardAdjacency.offsets[i + 1] += forwardAdjacency.offsets[i];
+        inverseAdjacency.offsets[i + 1] += inverseAdjacency.offsets[i];
+    }
+    forwardAdjacency.targets.resize(edges.size());
+    forwardAdjacency.owners.resize(edges.size());
+    inverseAdjacency.targets.resize(edges.size());
+    inverseAdjacency.owners.resize(edges.size());
+    std::vector<std::size_t> forwardNext(forwardAdjacency.offsets.begin(), forwardAdjacency.offsets.end() - 1);
+    std::vector<std::size_t> inverseNext(inverseAdjacency.offsets.begin(), inverseAdjacency.offsets.end() - 1);
+    for (const auto& edge : edges)
+    {
+        const std::size_t forwardSlot(forwardNext[std::get<0>(edge)]++);
+        forwardAdjacency.targets[forwardSlot] = std::get<1>(edge);
+        forwardAdjacency.owners[forwardSlot] = std::get<2>(edge);
+        const std::size_t inverseSlot(inverseNext[std::get<1>(edge)]++);
+        inverseAdjacency.targets[inverseSlot] = std::get<0>(edge);
+        inverseAdjacency.owners[inverseSlot] = std::get<2>(edge);
+    }
+}
+
+void Model::patchConnectivity(const Hyperedges& ownerUids)
+{
+    DROCK_TRACE_SCOPE("patchConnectivity", {{"owners", std::to_string(ownerUids.size())}});
+    // The compiled edges of the given owners are masked and their current connections are kept in per node lists instead.
+    // Costs are proportional to the connections of these owners, not to the size of the catalogue.
+    for (const UniqueId& ownerUid : ownerUids)
+    {
+        std::unordered_map<UniqueId, std::size_t>::const_iterator nit(connectivityNodeIds.find(ownerUid));
+        if (nit != connectivityNodeIds.end())
+        {
+            const std::size_t ownerId(nit->second);
+            if (ownerId < staleOwners.size())
+                staleOwners[ownerId] = true;
+            // Drop the patches of an earlier change
+            std::unordered_map<std::size_t, DeltaEdges>::iterator dit(deltaEdgesOf.find(ownerId));
+            if (dit != deltaEdgesOf.end())
+            {
+                auto ownedBy = [ownerId](const std::pair<std::size_t, std::size_t>& entry) { return entry.second == ownerId; };
+                for (const auto& edge : dit->second)
+                {
+                    DeltaEdges& forward(forwardDelta[edge.first]);
+                    forward.erase(std::remove_if(forward.begin(), forward.end(), ownedBy), forward.end());
+                    DeltaEdges& inverse(inverseDelta[edge.second]);
+                    inverse.erase(std::remove_if(inverse.begin(), inverse.end(), ownedBy), inverse.end());
+                }
+                nDeltaEdges -= dit->second.size();
+                deltaEdgesOf.erase(dit);
+            }
+        }
+        std::unordered_map<UniqueId, Connections>::const_iterator cit(connectionsOf.find(ownerUid));
+        if (cit == connectionsOf.end())
+            continue;
+        const std::size_t ownerId(connectivityNodeId(ownerUid));
+        DeltaEdges& ownEdges(deltaEdgesOf[ownerId]);
+        for (const auto& connection : cit->second)
+        {
+            const std::size_t fromId(connectivityNodeId(connection.first));
+            const std::size_t toId(connectivityNodeId(connection.second));
+            if (fromId == toId)
+                continue;
+            forwardDelta[fromId].push_back(std::make_pair(toId, ownerId));
+            inverseDelta[toId].push_back(std::make_pair(fromId, ownerId));
+            ownEdges.push_back(std::make_pair(fromId, toId));
+        }
+        nDeltaEdges += ownEdges.size();
+    }
+
+    // Compact once the patches outnumber the compiled edges: Each compaction follows at least as many patched edges as it sorts,
+    // so its costs are amortized over the imports.
+    if (nDeltaEdges > forwardAdjacency.targets.size())
+        compileConnectivity();
+}
+
+void Model::ensureConnectivity()
+{
+    const std::string edgePrefix(Model::EdgeTypeId+"::");
+    if (!connectivityValid)
+    {
+        // Unknown changes: Collect the connections of all models and all of their instances (which includes all parts)
+        DROCK_TRACE_SCOPE("rebuildConnectivity");
+        connectionsOf.clear();
+        connectivityPendingUids.clear();
+        edgeRelationUids.clear();
+        Hyperedges allUids(find());
+        for (const UniqueId& uid : allUids)
+        {
+            if (!uid.compare(0, edgePrefix.size(), edgePrefix) && (uid != Model::HasConfigId))
+                edgeRelationUids.insert(uid);
+        }
+        ensureIndices();
+        std::vector<UniqueId> versionUids;
+        for (const auto& entry : versionIndex)
+            versionUids.insert(versionUids.end(), entry.second.begin(), entry.second.end());
+        Hyperedges modelUids(unite(Hyperedges(), Hyperedges(versionUids.begin(), versionUids.end())));
+        collectConnections(unite(modelUids, instancesOf(modelUids)));
+        compileConnectivity();
+        connectivityValid = true;
+        return;
+    }
+    if (connectivityPendingUids.empty())
+        return;
+
+    // Imports only touch the models (and their parts) they create
+    // NOTE: Edge types used by imports have been indexed while importing
+    for (const auto& entry : factsFromIndex)
+    {
+        if (!entry.first.compare(0, edgePrefix.size(), edgePrefix) && (entry.first != Model::HasConfigId))
+            edgeRelationUids.insert(entry.first);
+    }
+    Hyperedges ownerUids;
+    for (const UniqueId& pendingUid : connectivityPendingUids)
+    {
+        Hyperedges modelUids(unite(Hyperedges{pendingUid}, versionsOf(pendingUid)));
+        ownerUids = unite(ownerUids, unite(modelUids, componentsOf(modelUids)));
+    }
+    connectivityPendingUids.clear();
+    collectConnections(ownerUids);
+    patchConnectivity(ownerUids);
+}
+
+void Model::traverse(const Hyperedges& uids, const TraversalDirection dir, const std::size_t maxHops, const UniqueId& targetUid,
+                     std::vector<std::size_t>& hops, std::vector<std::size_t>& parents)
+{
+    // Breadth first search over the compiled adjacency. Stops early once targetUid (if any) has been reached
+    ensureConnectivity();
+    const std::size_t unreached(static_cast<std::size_t>(-1));
+    hops.assign(connectivityNodes.size(), unreached);
+    parents.assign(connectivityNodes.size(), unreached);
+    std::unordered_map<UniqueId, std::size_t>::const_iterator tit(connectivityNodeIds.find(targetUid));
+    const std::size_t target(tit != connectivityNodeIds.end() ? tit->second : unreached);
+    std::vector<std::size_t> queue;
+    for (const UniqueId& uid : uids)
+    {
+        std::unordered_map<UniqueId, std::size_t>::const_iterator it(connectivityNodeIds.find(uid));
+        if ((it == connectivityNodeIds.end()) || (hops[it->second] != unreached))
+            continue;
+        hops[it->second] = 0;
+        queue.push_back(it->second);
+    }
+    const bool directions[2] = {dir != TraversalDirection::INVERSE, dir != TraversalDirection::FORWARD};
+    const Adjacency* adjacencies[2] = {&forwardAdjacency, &inverseAdjacency};
+    const std::vector<DeltaEdges>* deltas[2] = {&forwardDelta, &inverseDelta};
+    for (std::size_t head = 0; head < queue.size(); head++)
+    {
+        const std::size_t current(queue[head]);
+        if (current == target)
+            return;
+        if (maxHops && (hops[current] >= maxHops))
+            continue;
+        auto visit = [&](const std::size_t next) {
+            if (hops[next] != unreached)
+                return;
+            hops[next] = hops[current] + 1;
+            parents[next] = current;
+            queue.push_back(next);
+        };
+        for (std::size_t d = 0; d < 2; d++)
+        {
+            if (!directions[d])
+                continue;
+            // Compiled edges (unless their owner has been patched since) plus the patches
+            const Adjacency& adjacency(*adjacencies[d]);
+            if (current + 1 < adjacency.offsets.size())
+            {
+                for (std::size_t i = adjacency.offsets[current]; i < adjacency.offsets[current + 1]; i++)
+                {
+                    if (!staleOwners[adjacency.owners[i]])
+                        visit(adjacency.targets[i]);
+                }
+            }
+            for (const auto& entry : (*deltas[d])[current])
+                visit(entry.first);
+        }
+    }
+}
+
+std::map<UniqueId, std::size_t> Model::distancesFrom(const Hyperedges& uids, const TraversalDirection dir)
+{
+    std::vector<std::size_t> hops, parents;
+    traverse(uids, dir, 0, UniqueId(), hops, parents);
+    std::map<UniqueId, std::size_t> result;
+    for (const UniqueId& uid : uids)
+    {
+        if (exists(uid))
+            result[uid] = 0;
+    }
+    for (std::size_t i = 0; i < hops.size(); i++)
+    {
+        if (hops[i] != static_cast<std::size_t>(-1))
+            result[connectivityNodes[i]] = hops[i];
+    }
+    return result;
+}
+
+Hyperedges Model::reachableFrom(const Hyperedges& uids, const TraversalDirection dir, const std::size_t maxHops)
+{
+    std::vector<std::size_t> hops, parents;
+    traverse(uids, dir, maxHops, UniqueId(), hops, parents);
+    std::vector<UniqueId> result;
+    for (std::size_t i = 0; i < hops.size(); i++)
+    {
+        if (hops[i] && (hops[i] != static_cast<std::size_t>(-1)))
+            result.push_back(connectivityNodes[i]);
+    }
+    return unite(Hyperedges(), Hyperedges(result.begin(), result.end()));
+}
+
+std::vector<UniqueId> Model::pathBetween(const UniqueId& fromUid, const UniqueId& toUid, const TraversalDirection dir)
+{
+    std::vector<UniqueId> result;
+    if (fromUid == toUid)
+    {
+        if (exists(fromUid))
+            result.push_back(fromUid);
+        return result;
+    }
+    std::vector<std::size_t> hops, parents;
+    traverse(Hyperedges{fromUid}, dir, 0, toUid, hops, parents);
+    std::unordered_map<UniqueId, std::size_t>::const_iterator it(connectivityNodeIds.find(toUid));
+    if ((it == connectivityNodeIds.end()) || (hops[it->second] == static_cast<std::size_t>(-1)))
+        return result;
+    for (std::size_t current = it->second; current != static_cast<std::size_t>(-1); current = parents[current])
+        result.push_back(connectivityNodes[current]);
+    std::reverse(result.begin(), result.end());
+    return result;
 }
 
 bool Model::domainSpecificImport(const std::string& serialized)
 {
-    YAML::Node spec = YAML::Load(serialized);
+    YAML::Node spec;
+    {
+        DROCK_TRACE_SCOPE("YAML::Load");
+        spec = YAML::Load(serialized);
+    }
+    return importSpec(spec);
+}
+
+namespace {
+
+// A spec to be imported together with what it provides and what it needs
+struct ScheduledSpec
+{
+    YAML::Node spec;
+    std::string name;
+    std::vector<UniqueId> providedUids;
+    std::vector<UniqueId> requiredUids;
+    std::vector<std::string> messages;
+    bool valid;
+};
+
+// Runs job(i) for all i in [0, n) using all available cores
+template<typename Job> void runParallel(const std::size_t n, Job job)
+{
+    const std::size_t nThreads(std::min<std::size_t>(n, std::max<std::size_t>(1, std::thread::hardware_concurrency())));
+    std::atomic<std::size_t> next(0);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < nThreads; t++)
+    {
+        threads.push_back(std::thread([&]() {
+            for (std::size_t i = next++; i < n; i = next++)
+                job(i);
+        }));
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+}
+
+bool Model::domainSpecificImport(const std::vector<std::string>& serialized)
+{
+    // Parse all specs in parallel and collect the model versions they provide and require
+    std::vector<ScheduledSpec> specs(serialized.size());
+    runParallel(specs.size(), [&](const std::size_t i) {
+        ScheduledSpec& s(specs[i]);
+        s.valid = false;
+        // NOTE: Exceptions must not escape the worker threads
+        try {
+            DROCK_TRACE_SCOPE("YAML::Load", {{"spec", std::to_string(i)}});
+            s.spec = YAML::Load(serialized[i]);
+            if (!s.spec["domain"].IsDefined() || !s.spec["type"].IsDefined() || !s.spec["name"].IsDefined() || !s.spec["versions"].IsDefined())
+            {
+                s.messages.push_back("Spec #"+std::to_string(i)+" lacks domain, type, name or versions");
+                return;
+            }
+            const std::string domain(s.spec["domain"].as<std::string>());
+            s.name = s.spec["name"].as<std::string>();
+            const YAML::Node& versions(s.spec["versions"]);
+            for (auto it = versions.begin(); it != versions.end(); it++)
+            {
+                s.providedUids.push_back(getComponentUid(domain, s.name, (*it)["name"].as<std::string>()));
+                const YAML::Node& nodes((*it)["components"]["nodes"]);
+                for (auto nit = nodes.begin(); nit != nodes.end(); nit++)
+                {
+                    const YAML::Node& model((*nit)["model"]);
+                    s.requiredUids.push_back(getComponentUid(model["domain"].as<std::string>(), model["name"].as<std::string>(), model["version"].as<std::string>()));
+                }
+            }
+            s.valid = true;
+        } catch (const YAML::Exception& e) {
+            s.messages.push_back("Cannot parse spec #"+std::to_string(i)+": "+e.what());
+        }
+    });
+
+    // Build the dependency graph between specs and sort it topologically into waves of independent specs
+    std::unordered_map<UniqueId, std::vector<std::size_t> > providers;
+    for (std::size_t i = 0; i < specs.size(); i++)
+    {
+        for (const UniqueId& providedUid : specs[i].providedUids)
+            providers[providedUid].push_back(i);
+    }
+    std::vector< std::set<std::size_t> > dependents(specs.size());
+    std::vector<std::size_t> nDependencies(specs.size(), 0);
+    for (std::size_t i = 0; i < specs.size(); i++)
+    {
+        std::set<std::size_t> dependencies;
+        for (const UniqueId& requiredUid : specs[i].requiredUids)
+        {
+            std::unordered_map<UniqueId, std::vector<std::size_t> >::const_iterator it(providers.find(requiredUid));
+            if (it == providers.end())
+                continue;
+            // NOTE: Versions of a spec may use earlier versions of the same spec
+            for (const std::size_t provider : it->second)
+                if (provider != i)
+                    dependencies.insert(provider);
+        }
+        for (const std::size_t provider : dependencies)
+            dependents[provider].insert(i);
+        nDependencies[i] = dependencies.size();
+    }
+    std::vector< std::vector<std::size_t> > waves;
+    std::vector<std::size_t> wave;
+    for (std::size_t i = 0; i < specs.size(); i++)
+        if (!nDependencies[i])
+            wave.push_back(i);
+    std::size_t nScheduled(0);
+    while (!wave.empty())
+    {
+        waves.push_back(wave);
+        nScheduled += wave.size();
+        std::vector<std::size_t> nextWave;
+        for (const std::size_t i : wave)
+            for (const std::size_t dependent : dependents[i])
+                if (!--nDependencies[dependent])
+                    nextWave.push_back(dependent);
+        std::sort(nextWave.begin(), nextWave.end());
+        wave.swap(nextWave);
+    }
+    bool ok = true;
+    if (nScheduled < specs.size())
+    {
+        // Whatever remains is part of (or depends on) a cycle
+        ok = false;
+        for (std::size_t i = 0; i < specs.size(); i++)
+            if (nDependencies[i])
+                std::cout << "Spec " << specs[i].name << " is part of or depends on a cycle. Skipping\n";
+    }
+
+    for (const std::vector<std::size_t>& current : waves)
+    {
+        DROCK_TRACE_SCOPE("wave", {{"specs", std::to_string(current.size())}});
+        // Validate references of this wave in parallel (the graph is only read) ...
+        // NOTE: All other providers have been committed in earlier waves, so whatever does not exist by now
+        // (and is not provided by the spec itself) is unknown or has been provided by a spec which failed
+        runParallel(current.size(), [&](const std::size_t w) {
+            ScheduledSpec& s(specs[current[w]]);
+            if (!s.valid)
+                return;
+            for (const UniqueId& requiredUid : s.requiredUids)
+            {
+                if (exists(requiredUid) || (std::find(s.providedUids.begin(), s.providedUids.end(), requiredUid) != s.providedUids.end()))
+                    continue;
+                s.messages.push_back("Spec "+s.name+" refers to unknown model "+requiredUid+". Skipping");
+                s.valid = false;
+            }
+        });
+        // ... and commit them in input order
+        for (const std::size_t i : current)
+        {
+            for (const std::string& message : specs[i].messages)
+                std::cout << message << "\n";
+            if (!specs[i].valid || !importSpec(specs[i].spec))
+                ok = false;
+        }
+    }
+    return ok;
+}
+
+bool Model::importSpec(const YAML::Node& spec)
+{
 
     // Handle domain, type, name
     if (!spec["domain"].IsDefined())
@@ -182,6 +1513,7 @@ bool Model::domainSpecificImport(const std::string& serialized)
     if (!spec["name"].IsDefined())
         return false;
     const std::string name(spec["name"].as<std::string>());
+    DROCK_TRACE_SCOPE("domainSpecificImport", {{"domain", domain}, {"type", type}, {"component", name}});
 
     // Create domain
     // NOTE: For now the domain is related to subsequent components via IS-A relationship
@@ -192,8 +1524,13 @@ bool Model::domainSpecificImport(const std::string& serialized)
     createComponent(typeUid, type, Hyperedges{Model::ComponentTypeId});
     // Create a component by name which is a subclass of both a domain and a type
     const UniqueId superUid(getComponentUid(domain, name));
+    // From here on, all changes belong to this component
+    ChangeScope scope(changingComponentUid, superUid);
+    changed(superUid);
     createComponent(superUid, name, Hyperedges{typeUid});
     isA(Hyperedges{superUid}, Hyperedges{domainUid});
+    domainIndex[domainUid].insert(superUid);
+    typeIndex[typeUid].insert(superUid);
     // Link to lower meta models
     if (inSoftwareDomain(domainUid))
         isA(Hyperedges{superUid}, Hyperedges{Software::Graph::AlgorithmId});
@@ -208,8 +1545,11 @@ bool Model::domainSpecificImport(const std::string& serialized)
         // Create a subclass of superUid with label (name, vname)
         const YAML::Node& version(*it);
         const std::string& vname(version["name"].as<std::string>());
+        DROCK_TRACE_SCOPE("version", {{"component", name}, {"version", vname}});
         const UniqueId modelUid(getComponentUid(domain, name, vname));
         createComponent(modelUid, vname, Hyperedges{superUid});
+        versionIndex[superUid].insert(modelUid);
+        connectivityPendingUids.insert(modelUid);
 
         // Handle subcomponents & their interconnection. Create only if non-existing.
         Hyperedges validNodeUids;
@@ -229,10 +1569,15 @@ bool Model::domainSpecificImport(const std::string& serialized)
 
                     // Check if a node with the same name already exists in partUids
                     // Here we could make an optimization!!!
-                    Hyperedges partUids(componentsOf(Hyperedges{modelUid}, nodeName));
+                    Hyperedges partUids;
+                    {
+                        DROCK_TRACE_SCOPE("componentsOf", {{"version", vname}, {"node", nodeName}});
+                        partUids = componentsOf(Hyperedges{modelUid}, nodeName);
+                    }
                     if (!partUids.size())
                     {
                         // Instantiate new subcomponent
+                        DROCK_TRACE_SCOPE("instantiateComponent", {{"version", vname}, {"node", nodeName}, {"model", nodeModelName}, {"modelVersion", nodeModelVersion}});
                         // We need to find a component class named <nodeModelVersion> whose superclass is <nodeModelName> and its domain is <nodeModelDomain>
                         const UniqueId templateUid(getComponentUid(nodeModelDomain, nodeModelName, nodeModelVersion));
                         if (!exists(templateUid))
@@ -257,6 +1602,7 @@ bool Model::domainSpecificImport(const std::string& serialized)
                 {
                     const YAML::Node& edge(*eit);
                     const std::string& edgeName(edge["name"].as<std::string>());
+                    DROCK_TRACE_SCOPE("edge", {{"version", vname}, {"edge", edgeName}});
                     std::string edgeType("NOT_SET");
                     if (edge["type"].IsDefined())
                     {
@@ -284,24 +1630,23 @@ bool Model::domainSpecificImport(const std::string& serialized)
                             std::cout << "Don't know relation of type " << edgeType << "\n";
                             continue;
                         }
-                        // Get all facts from relUid by name
-                        Hyperedges factUids(factsOf(relUid, edgeName));
                         // Lookup entities to relate from and to
                         for (const UniqueId& fromUid : validNodeUids)
                         {
                             if (read(fromUid).label() != sourceNodeName)
                                 continue;
-                            Hyperedges relsFromUids(relationsFrom(Hyperedges{fromUid}, edgeName));
                             for (const UniqueId& toUid : validNodeUids)
                             {
                                 if (read(toUid).label() != targetNodeName)
                                     continue;
-                                Hyperedges relsToUids(relationsTo(Hyperedges{toUid}, edgeName));
-                                Hyperedges possibleCandidateUids(intersect(factUids, intersect(relsFromUids, relsToUids)));
+                                // Only facts of relUid between fromUid and toUid are candidates
+                                Hyperedges possibleCandidateUids(factsBetween(relUid, Hyperedges{fromUid}, Hyperedges{toUid}, edgeName));
                                 if (!possibleCandidateUids.size())
                                 {
+                                    DROCK_TRACE_SCOPE("factFrom", {{"edge", edgeName}});
                                     Hyperedges factUid(factFrom(Hyperedges{fromUid}, Hyperedges{toUid}, Hyperedges{relUid}));
                                     get(*factUid.begin()).updateLabel(edgeName);
+                                    indexFacts(relUid, factUid);
                                     possibleCandidateUids = unite(possibleCandidateUids, factUid);
                                 }
                                 // Register (possibly new) edges for later use
@@ -312,27 +1657,34 @@ bool Model::domainSpecificImport(const std::string& serialized)
                         // These edges are based on interfaces. We can model them via ConnectedToInterfaceId.
                         const std::string& sourceInterfaceName(from["interface"].as<std::string>());
                         const std::string& targetInterfaceName(to["interface"].as<std::string>());
-                        // Get all facts from relUid by name
-                        Hyperedges factUids(factsOf(Component::Network::ConnectedToInterfaceId, edgeName));
                         // Lookup entities to relate from and to
                         for (const UniqueId& fromUid : validNodeUids)
                         {
                             if (read(fromUid).label() != sourceNodeName)
                                 continue;
-                            Hyperedges fromInterfaceUids(interfacesOf(Hyperedges{fromUid}, sourceInterfaceName));
-                            Hyperedges relsFromUids(relationsFrom(fromInterfaceUids, edgeName));
+                            Hyperedges fromInterfaceUids;
+                            {
+                                DROCK_TRACE_SCOPE("interfacesOf", {{"edge", edgeName}, {"interface", sourceInterfaceName}});
+                                fromInterfaceUids = interfacesOf(Hyperedges{fromUid}, sourceInterfaceName);
+                            }
                             for (const UniqueId& toUid : validNodeUids)
                             {
                                 if (read(toUid).label() != targetNodeName)
                                     continue;
-                                Hyperedges toInterfaceUids(interfacesOf(Hyperedges{toUid}, targetInterfaceName));
-                                Hyperedges relsToUids(relationsTo(toInterfaceUids, edgeName));
-                                Hyperedges possibleCandidateUids(intersect(factUids, intersect(relsFromUids, relsToUids)));
+                                Hyperedges toInterfaceUids;
+                                {
+                                    DROCK_TRACE_SCOPE("interfacesOf", {{"edge", edgeName}, {"interface", targetInterfaceName}});
+                                    toInterfaceUids = interfacesOf(Hyperedges{toUid}, targetInterfaceName);
+                                }
+                                // Only connections between the two sets of interfaces are candidates
+                                Hyperedges possibleCandidateUids(factsBetween(Component::Network::ConnectedToInterfaceId, fromInterfaceUids, toInterfaceUids, edgeName));
                                 if (!possibleCandidateUids.size())
                                 {
+                                    DROCK_TRACE_SCOPE("connectInterface", {{"edge", edgeName}});
                                     Hyperedges connUids(connectInterface(fromInterfaceUids, toInterfaceUids));
                                     for (const UniqueId& connUid : connUids)
                                         get(connUid).updateLabel(edgeName);
+                                    indexFacts(Component::Network::ConnectedToInterfaceId, connUids);
                                     possibleCandidateUids = unite(possibleCandidateUids, connUids);
                                 }
                                 // Register (possibly new) edges for later use
@@ -364,7 +1716,8 @@ bool Model::domainSpecificImport(const std::string& serialized)
                             instantiateConfigOnce(Hyperedges{partUid}, nodeData);
                         }
 
-                        // TODO: Shall we follow the submodel chain? That means that we might have to use instantiateSuperDeepFrom!
+                        // NOTE: Import stays one level deep, parts refer to model versions which share their structure.
+                        // Concrete nested instances can be created with instantiateDeepFrom.
                     }
                 }
                 if (edgesConfig.IsDefined())
@@ -383,7 +1736,8 @@ bool Model::domainSpecificImport(const std::string& serialized)
                             instantiateConfigOnce(Hyperedges{relUid}, edgeData);
                         }
 
-                        // TODO: Shall we follow the submodel chain? That means that we might have to use instantiateSuperDeepFrom!
+                        // NOTE: Import stays one level deep, parts refer to model versions which share their structure.
+                        // Concrete nested instances can be created with instantiateDeepFrom.
                     }
                 }
             }
@@ -398,11 +1752,16 @@ bool Model::domainSpecificImport(const std::string& serialized)
             {
                 const YAML::Node& interfaceYAML(*ifIt);
                 const std::string& ifName(interfaceYAML["name"].as<std::string>());
+                DROCK_TRACE_SCOPE("interface", {{"version", vname}, {"interface", ifName}});
                 const std::string& ifType(interfaceYAML["type"].as<std::string>());
                 const std::string& ifDirection(interfaceYAML["direction"].as<std::string>());
 
                 // Check if interface already exists.
-                Hyperedges interfaceUids(interfacesOf(Hyperedges{modelUid}, ifName));
+                Hyperedges interfaceUids;
+                {
+                    DROCK_TRACE_SCOPE("interfacesOf", {{"version", vname}, {"interface", ifName}});
+                    interfaceUids = interfacesOf(Hyperedges{modelUid}, ifName);
+                }
                 if (interfaceUids.size())
                 {
                     // Interface already exists, so ignore it.
@@ -445,7 +1804,11 @@ bool Model::domainSpecificImport(const std::string& serialized)
                         if (read(partUid).label() != interfaceLinkNodeName)
                             continue;
                         // Found. Find all interfaces with given name.
-                        Hyperedges interfaceUids(interfacesOf(Hyperedges{partUid}, interfaceLinkInterfaceName));
+                        Hyperedges interfaceUids;
+                        {
+                            DROCK_TRACE_SCOPE("interfacesOf", {{"version", vname}, {"interface", interfaceLinkInterfaceName}});
+                            interfaceUids = interfacesOf(Hyperedges{partUid}, interfaceLinkInterfaceName);
+                        }
                         allInterfaces = unite(allInterfaces, instantiateAliasInterfaceFor(Hyperedges{modelUid}, interfaceUids, ifName));
                     }
                 } else {
@@ -477,6 +1840,19 @@ std::string Model::domainSpecificExport(const UniqueId& uid)
     if (!exists(uid))
         return std::string();
 
+    // Serve from cache if neither the component nor the whole graph changed since the last export
+    std::unordered_map<UniqueId, CachedExport>::const_iterator cit(exportCache.find(uid));
+    if (cit != exportCache.end())
+    {
+        const CachedExport& cached(cit->second);
+        std::unordered_map<UniqueId, std::size_t>::const_iterator git(componentGenerations.find(cached.componentUid));
+        const std::size_t componentGeneration(git != componentGenerations.end() ? git->second : 0);
+        if ((cached.generation >= globalGeneration) && (cached.generation >= componentGeneration))
+            return cached.result;
+    }
+
+    DROCK_TRACE_SCOPE("domainSpecificExport", {{"component", uid}});
+
     // Find all superclasses of uid
     // This includes everything upwards (domain, type, etc.)
     Hyperedges superUids(subclassesOf(uid, "", TraversalDirection::FORWARD));
@@ -535,12 +1911,14 @@ std::string Model::domainSpecificExport(const UniqueId& uid)
     Hyperedges allVersions(directSubclassesOf(componentUids));
     for (const UniqueId& versionUid : allVersions)
     {
+        DROCK_TRACE_SCOPE("version", {{"version", versionUid}});
         YAML::Node versionYAML;
         versionYAML["name"] = read(versionUid).label();
 
         // Handle subcomponents
         YAML::Node componentsYAML(versionYAML["components"]);
-        YAML::Node configurationYAML(versionYAML["configuration"]);
+        // NOTE: The configuration of parts and their interconnections belongs to the components (see domainSpecificImport)
+        YAML::Node configurationYAML(componentsYAML["configuration"]);
         Hyperedges partUids(componentsOf(Hyperedges{versionUid}));
         if (partUids.size())
         {
@@ -552,13 +1930,19 @@ std::string Model::domainSpecificExport(const UniqueId& uid)
                 nodeYAML["name"] = read(partUid).label();
                 // the direct superclass is the model version
                 Hyperedges versionUids(instancesOf(Hyperedges{partUid}, "", TraversalDirection::FORWARD));
-                nodeYAML["model"]["version"] = read(*versionUids.begin()).label();
                 // the next superclasses is the model itself (NOTE: get rid of the upper models)
                 Hyperedges modelUids(directSubclassesOf(versionUids, "", TraversalDirection::FORWARD));
                 modelUids = subtract(modelUids, Hyperedges{Model::ComponentId, Component::Network::ComponentId});
-                nodeYAML["model"]["name"] = read(*modelUids.begin()).label();
                 // and the next superclasses are the type and the domain
                 Hyperedges modelDomainUids(intersect(directSubclassesOf(modelUids, "", TraversalDirection::FORWARD), allDomainUids));
+                // NOTE: The model might be missing, e.g. if it belongs to a shard which has not been loaded
+                if (!versionUids.size() || !modelUids.size() || !modelDomainUids.size())
+                {
+                    std::cout << "Cannot find model of part " << read(partUid).label() << ". Abort\n";
+                    return std::string();
+                }
+                nodeYAML["model"]["version"] = read(*versionUids.begin()).label();
+                nodeYAML["model"]["name"] = read(*modelUids.begin()).label();
                 nodeYAML["model"]["domain"] = read(*modelDomainUids.begin()).label();
                 nodesYAML.push_back(nodeYAML);
 
@@ -675,21 +2059,25 @@ std::string Model::domainSpecificExport(const UniqueId& uid)
         }
 
         // Store default configuration
-        YAML::Node defaultConfigYAML(versionYAML["defaultConfiguration"]);
+        // NOTE: There is only one config per entity (see instantiateConfigOnce)
         Hyperedges configUids(configsOf(Hyperedges{versionUid}));
         for (const UniqueId& configUid : configUids)
         {
-            YAML::Node configYAML;
-            configYAML["name"] = read(versionUid).label();
-            configYAML["data"] = read(configUid).label();
-            defaultConfigYAML.push_back(configYAML);
+            YAML::Node defaultConfigYAML(versionYAML["defaultConfiguration"]);
+            defaultConfigYAML["name"] = read(versionUid).label();
+            defaultConfigYAML["data"] = read(configUid).label();
         }
 
         versionsYAML.push_back(versionYAML);
     }
 
     ss << spec;
-    return ss.str();
+
+    CachedExport& cached(exportCache[uid]);
+    cached.generation = generation;
+    cached.componentUid = *componentUids.begin();
+    cached.result = ss.str();
+    return cached.result;
 }
 
 
@@ -0,0 +1,1036 @@
+#include "BasicModel.hpp"
+#include "HypergraphYAML.hpp"
+#include <yaml-cpp/yaml.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include <set>
+#include <algorithm>
+#include <functional>
+#include <getopt.h>
+#include <unistd.h>
+
+static struct option long_options[] = {
+    {"help", no_argument, 0, 'h'},
+    {"seed", required_argument, 0, 's'},
+    {"specs", required_argument, 0, 'n'},
+    {"size", required_argument, 0, 'z'},
+    {"max-import-ms", required_argument, 0, 'i'},
+    {"max-export-ms", required_argument, 0, 'e'},
+    {"timings", required_argument, 0, 't'},
+    {"baseline", required_argument, 0, 'b'},
+    {"tolerance", required_argument, 0, 'r'},
+    {"check", required_argument, 0, 'c'},
+    {0,0,0,0}
+};
+
+void usage (const char *myName)
+{
+    std::cout << "Usage:\n";
+    std::cout << myName << " [options]\n\n";
+    std::cout << "Options:\n";
+    std::cout << "--help\t" << "Show usage\n";
+    std::cout << "--seed <n>\t" << "Seed for generating random specs (default: 1)\n";
+    std::cout << "--specs <n>\t" << "Number of random specs to import, export and re-import (default: 20)\n";
+    std::cout << "--size <n>\t" << "Number of parts of the reference model to time (default: 0, no timing)\n";
+    std::cout << "--max-import-ms <ms>\t" << "Fail if importing the reference model takes longer\n";
+    std::cout << "--max-export-ms <ms>\t" << "Fail if exporting the reference model takes longer\n";
+    std::cout << "--timings <file>\t" << "Store the recorded timings\n";
+    std::cout << "--baseline <file>\t" << "Fail if timings exceed the ones stored in <file> by more than the tolerance\n";
+    std::cout << "--tolerance <factor>\t" << "Allowed slowdown w.r.t. the baseline (default: 1.5)\n";
+    std::cout << "--check <name>\t" << "Run only the given check (can be given multiple times, default: all checks if --specs is not 0)\n";
+    std::cout << "\t" << "roundtrip, connectivity, deep-instantiation, shards, scheduled-import, export-cache, save, memory-report\n";
+    std::cout << "\nExample:\n";
+    std::cout << myName << " --seed 42 --specs 50\n";
+    std::cout << myName << " --seed 42 --specs 50 --check shards\n";
+    std::cout << myName << " --specs 0 --size 100 --timings drock-timings.yml --baseline drock-timings-last-release.yml\n";
+}
+
+// All entities of a spec as flat, comparable strings
+typedef std::set<std::string> CanonicalSpec;
+
+static std::string field(const YAML::Node& node, const std::string& key, const std::string& fallback="")
+{
+    if (!node.IsMap() || !node[key].IsDefined() || node[key].IsNull())
+        return fallback;
+    return node[key].as<std::string>();
+}
+
+static CanonicalSpec canonical(const YAML::Node& spec)
+{
+    CanonicalSpec result;
+    result.insert("domain|"+field(spec, "domain"));
+    result.insert("type|"+field(spec, "type"));
+    result.insert("name|"+field(spec, "name"));
+    const YAML::Node& versions(spec["versions"]);
+    for (auto it = versions.begin(); it != versions.end(); it++)
+    {
+        const YAML::Node& version(*it);
+        const std::string v("version|"+field(version, "name")+"|");
+        result.insert(v);
+        const YAML::Node& components(version["components"]);
+        if (components.IsDefined())
+        {
+            const YAML::Node& nodes(components["nodes"]);
+            for (auto nit = nodes.begin(); nit != nodes.end(); nit++)
+            {
+                const YAML::Node& node(*nit);
+                result.insert(v+"node|"+field(node, "name")+"|"+field(node["model"], "domain")+"|"+field(node["model"], "name")+"|"+field(node["model"], "version"));
+            }
+            const YAML::Node& edges(components["edges"]);
+            for (auto eit = edges.begin(); eit != edges.end(); eit++)
+            {
+                const YAML::Node& edge(*eit);
+                result.insert(v+"edge|"+field(edge, "name")+"|"+field(edge, "type", "NOT_SET")+"|"
+                        +field(edge["from"], "name")+"|"+field(edge["from"], "interface")+"|"
+                        +field(edge["to"], "name")+"|"+field(edge["to"], "interface"));
+            }
+            const YAML::Node& config(components["configuration"]);
+            if (config.IsDefined())
+            {
+                const YAML::Node& nodesConfig(config["nodes"]);
+                for (auto nit = nodesConfig.begin(); nit != nodesConfig.end(); nit++)
+                    result.insert(v+"nodeConfig|"+field(*nit, "name")+"|"+field(*nit, "data"));
+                const YAML::Node& edgesConfig(config["edges"]);
+                for (auto eit = edgesConfig.begin(); eit != edgesConfig.end(); eit++)
+                    result.insert(v+"edgeConfig|"+field(*eit, "name")+"|"+field(*eit, "data"));
+            }
+        }
+        const YAML::Node& ifs(version["interfaces"]);
+        for (auto ifIt = ifs.begin(); ifIt != ifs.end(); ifIt++)
+        {
+            const YAML::Node& interfaceYAML(*ifIt);
+            result.insert(v+"interface|"+field(interfaceYAML, "name")+"|"+field(interfaceYAML, "type")+"|"+field(interfaceYAML, "direction")+"|"
+                    +field(interfaceYAML, "linkToNode")+"|"+field(interfaceYAML, "linkToInterface"));
+        }
+        const YAML::Node& defaultConfig(version["defaultConfiguration"]);
+        if (defaultConfig.IsDefined())
+            result.insert(v+"defaultConfig|"+field(defaultConfig, "data"));
+    }
+    return result;
+}
+
+static bool equivalent(const CanonicalSpec& expected, const CanonicalSpec& actual, const std::string& what)
+{
+    if (expected == actual)
+        return true;
+    std::cout << what << " differs\n";
+    for (const std::string& entry : expected)
+        if (!actual.count(entry))
+            std::cout << "  missing: " << entry << "\n";
+    for (const std::string& entry : actual)
+        if (!expected.count(entry))
+            std::cout << "  unexpected: " << entry << "\n";
+    return false;
+}
+
+// Generated specs together with the information needed to reference them from later specs
+struct Interface
+{
+    std::string name;
+    std::string type;
+    std::string direction;
+};
+
+struct GeneratedVersion
+{
+    std::string name;
+    std::vector<Interface> interfaces;
+};
+
+struct GeneratedSpec
+{
+    std::string domain;
+    std::string name;
+    std::vector<GeneratedVersion> versions;
+    YAML::Node spec;
+};
+
+static bool canSend(const Interface& i)
+{
+    return (i.direction == "OUTGOING") || (i.direction == "BIDIRECTIONAL");
+}
+
+static bool canReceive(const Interface& i)
+{
+    return (i.direction == "INCOMING") || (i.direction == "BIDIRECTIONAL");
+}
+
+// Generates a spec which may use all previously generated specs as parts
+static GeneratedSpec generate(std::mt19937& rng, const std::size_t index, const std::vector<GeneratedSpec>& previous, const std::size_t maxParts)
+{
+    static const char* domains[] = {"SOFTWARE", "COMPUTATION"};
+    static const char* types[] = {"TASK", "PROCESSOR", "DEVICE"};
+    static const char* ifTypes[] = {"INT", "FLOAT", "ETHERNET"};
+    static const char* ifDirections[] = {"INCOMING", "OUTGOING", "BIDIRECTIONAL"};
+    std::uniform_int_distribution<std::size_t> coin(0, 1);
+    std::uniform_int_distribution<std::size_t> three(0, 2);
+
+    GeneratedSpec result;
+    result.domain = domains[coin(rng)];
+    result.name = "component"+std::to_string(index);
+    result.spec["domain"] = result.domain;
+    result.spec["type"] = types[three(rng)];
+    result.spec["name"] = result.name;
+
+    const std::size_t nVersions(1 + coin(rng));
+    for (std::size_t v = 0; v < nVersions; v++)
+    {
+        GeneratedVersion version;
+        version.name = "v"+std::to_string(v);
+        YAML::Node versionYAML;
+        versionYAML["name"] = version.name;
+
+        // Parts: instances of versions of previous specs
+        std::vector<const GeneratedVersion*> partModels;
+        const std::size_t nParts(previous.size() && maxParts ? std::uniform_int_distribution<std::size_t>(0, maxParts)(rng) : 0);
+        for (std::size_t p = 0; p < nParts; p++)
+        {
+            const GeneratedSpec& other(previous[std::uniform_int_distribution<std::size_t>(0, previous.size()-1)(rng)]);
+            const GeneratedVersion& otherVersion(other.versions[std::uniform_int_distribution<std::size_t>(0, other.versions.size()-1)(rng)]);
+            YAML::Node nodeYAML;
+            nodeYAML["name"] = "node"+std::to_string(p);
+            nodeYAML["model"]["domain"] = other.domain;
+            nodeYAML["model"]["name"] = other.name;
+            nodeYAML["model"]["version"] = otherVersion.name;
+            versionYAML["components"]["nodes"].push_back(nodeYAML);
+            if (coin(rng))
+            {
+                YAML::Node nodeConfigYAML;
+                nodeConfigYAML["name"] = "node"+std::to_string(p);
+                nodeConfigYAML["data"] = "node-config-"+std::to_string(rng());
+                versionYAML["components"]["configuration"]["nodes"].push_back(nodeConfigYAML);
+            }
+            partModels.push_back(&otherVersion);
+        }
+
+        // Edges: typed relations and connections between compatible interfaces
+        std::size_t nEdges(0);
+        for (std::size_t from = 0; from < partModels.size(); from++)
+        {
+            for (std::size_t to = 0; to < partModels.size(); to++)
+            {
+                if ((from == to) || coin(rng))
+                    continue;
+                YAML::Node edgeYAML;
+                edgeYAML["name"] = "edge"+std::to_string(nEdges);
+                edgeYAML["from"]["name"] = "node"+std::to_string(from);
+                edgeYAML["to"]["name"] = "node"+std::to_string(to);
+                if (coin(rng))
+                {
+                    edgeYAML["type"] = "DEPENDS_ON";
+                } else {
+                    bool found = false;
+                    for (const Interface& fromIf : partModels[from]->interfaces)
+                    {
+                        for (const Interface& toIf : partModels[to]->interfaces)
+                        {
+                            if (found || !canSend(fromIf) || !canReceive(toIf) || (fromIf.type != toIf.type))
+                                continue;
+                            edgeYAML["from"]["interface"] = fromIf.name;
+                            edgeYAML["to"]["interface"] = toIf.name;
+                            found = true;
+                        }
+                    }
+                    if (!found)
+                        continue;
+                }
+                versionYAML["components"]["edges"].push_back(edgeYAML);
+                if (coin(rng))
+                {
+                    YAML::Node edgeConfigYAML;
+                    edgeConfigYAML["name"] = "edge"+std::to_string(nEdges);
+                    edgeConfigYAML["data"] = "edge-config-"+std::to_string(rng());
+                    versionYAML["components"]["configuration"]["edges"].push_back(edgeConfigYAML);
+                }
+                nEdges++;
+            }
+        }
+
+        // Interfaces: either new ones or aliases of interfaces of parts
+        const std::size_t nInterfaces(1 + three(rng));
+        for (std::size_t i = 0; i < nInterfaces; i++)
+        {
+            Interface generatedIf;
+            generatedIf.name = "if"+std::to_string(i);
+            YAML::Node interfaceYAML;
+            interfaceYAML["name"] = generatedIf.name;
+            if (partModels.size() && coin(rng))
+            {
+                // Aliases inherit type and direction of the original interface
+                const std::size_t p(std::uniform_int_distribution<std::size_t>(0, partModels.size()-1)(rng));
+                if (partModels[p]->interfaces.size())
+                {
+                    const Interface& original(partModels[p]->interfaces[std::uniform_int_distribution<std::size_t>(0, partModels[p]->interfaces.size()-1)(rng)]);
+                    generatedIf.type = original.type;
+                    generatedIf.direction = original.direction;
+                    interfaceYAML["linkToNode"] = "node"+std::to_string(p);
+                    interfaceYAML["linkToInterface"] = original.name;
+                }
+            }
+            if (generatedIf.type.empty())
+            {
+                generatedIf.type = ifTypes[three(rng)];
+                generatedIf.direction = ifDirections[three(rng)];
+            }
+            interfaceYAML["type"] = generatedIf.type;
+            interfaceYAML["direction"] = generatedIf.direction;
+            versionYAML["interfaces"].push_back(interfaceYAML);
+            version.interfaces.push_back(generatedIf);
+        }
+
+        if (coin(rng))
+        {
+            versionYAML["defaultConfiguration"]["name"] = version.name;
+            versionYAML["defaultConfiguration"]["data"] = "default-config-"+std::to_string(rng());
+        }
+
+        result.spec["versions"].push_back(versionYAML);
+        result.versions.push_back(version);
+    }
+    return result;
+}
+
+// Typed edges refer to relations which have to be known beforehand
+static void setupRelations(Drock::Model& dc)
+{
+    const UniqueId relUid(dc.getEdgeUid("DEPENDS_ON"));
+    dc.subrelationFrom(relUid, Hyperedges{Drock::Model::ComponentId}, Hyperedges{Drock::Model::ComponentId}, CommonConceptGraph::HasAId);
+    dc.get(relUid).updateLabel("DEPENDS_ON");
+    // Changed by other means than importing
+    dc.invalidate();
+}
+
+static std::string serialize(const YAML::Node& spec)
+{
+    std::stringstream ss;
+    ss << spec;
+    return ss.str();
+}
+
+// Generates nSpecs random specs and imports them one after another into dc
+// NOTE: afterEach (if given) is called after every import
+static bool importGenerated(const unsigned int seed, const std::size_t nSpecs, Drock::Model& dc, std::vector<GeneratedSpec>& specs,
+                            const std::function<void (const GeneratedSpec&)>& afterEach=std::function<void (const GeneratedSpec&)>())
+{
+    std::mt19937 rng(seed);
+    specs.clear();
+    for (std::size_t i = 0; i < nSpecs; i++)
+        specs.push_back(generate(rng, i, specs, 4));
+
+    setupRelations(dc);
+    for (const GeneratedSpec& spec : specs)
+    {
+        if (!dc.domainSpecificImport(serialize(spec.spec)))
+        {
+            std::cout << "Import of " << spec.name << " failed\n";
+            return false;
+        }
+        if (afterEach)
+            afterEach(spec);
+    }
+    return true;
+}
+
+static double msSince(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Import -> export -> re-import -> export of randomized specs
+static bool checkRoundTrip(const unsigned int seed, const std::size_t nSpecs)
+{
+    std::vector<GeneratedSpec> specs;
+    Drock::Model first;
+    if (!importGenerated(seed, nSpecs, first, specs))
+        return false;
+
+    bool ok = true;
+    std::vector<std::string> exported;
+    for (const GeneratedSpec& spec : specs)
+    {
+        exported.push_back(first.domainSpecificExport(first.getComponentUid(spec.domain, spec.name)));
+        ok = equivalent(canonical(spec.spec), canonical(YAML::Load(exported.back())), "Export of "+spec.name) && ok;
+    }
+
+    Drock::Model second;
+    setupRelations(second);
+    for (std::size_t i = 0; i < specs.size(); i++)
+    {
+        if (!second.domainSpecificImport(exported[i]))
+        {
+            std::cout << "Re-import of " << specs[i].name << " failed\n";
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < specs.size(); i++)
+    {
+        const std::string reexported(second.domainSpecificExport(second.getComponentUid(specs[i].domain, specs[i].name)));
+        ok = equivalent(canonical(YAML::Load(exported[i])), canonical(YAML::Load(reexported)), "Re-export of "+specs[i].name) && ok;
+    }
+
+    // Instances get new UIDs, but both graphs have to consist of the same number of entities
+    const std::size_t firstSize(first.find().size());
+    const std::size_t secondSize(second.find().size());
+    if (firstSize != secondSize)
+    {
+        std::cout << "Graphs differ in size: " << firstSize << " vs. " << secondSize << "\n";
+        ok = false;
+    }
+    std::cout << "Round trip of " << nSpecs << " specs (seed " << seed << "): " << (ok ? "OK" : "FAILED") << "\n";
+    return ok;
+}
+
+// The streamed graph has to be readable by the hypergraph decoder (as used by drock-export-model) and yield the same graph
+static bool checkSave(const unsigned int seed, const std::size_t nSpecs)
+{
+    std::vector<GeneratedSpec> specs;
+    Drock::Model dc;
+    if (!importGenerated(seed, nSpecs, dc, specs))
+        return false;
+    std::stringstream ss;
+    dc.saveTo(ss);
+    Hypergraph loaded;
+    try {
+        loaded = YAML::Load(ss.str()).as<Hypergraph>();
+    } catch (const YAML::Exception& e) {
+        std::cout << "Cannot decode stored graph: " << e.what() << "\n";
+        return false;
+    }
+
+    bool ok = true;
+    const Hyperedges uids(dc.find());
+    const Hyperedges loadedUids(loaded.find());
+    if (std::set<UniqueId>(uids.begin(), uids.end()) != std::set<UniqueId>(loadedUids.begin(), loadedUids.end()))
+    {
+        std::cout << "Stored graph has " << loadedUids.size() << " instead of " << uids.size() << " entities\n";
+        ok = false;
+    }
+    for (const UniqueId& uid : uids)
+    {
+        if (!loaded.exists(uid))
+            continue;
+        const Hyperedges fromUids(dc.from(Hyperedges{uid}));
+        const Hyperedges toUids(dc.to(Hyperedges{uid}));
+        const Hyperedges loadedFromUids(loaded.from(Hyperedges{uid}));
+        const Hyperedges loadedToUids(loaded.to(Hyperedges{uid}));
+        if ((dc.read(uid).label() == loaded.read(uid).label()) &&
+            (std::set<UniqueId>(fromUids.begin(), fromUids.end()) == std::set<UniqueId>(loadedFromUids.begin(), loadedFromUids.end())) &&
+            (std::set<UniqueId>(toUids.begin(), toUids.end()) == std::set<UniqueId>(loadedToUids.begin(), loadedToUids.end())))
+            continue;
+        std::cout << "Stored entity " << uid << " differs\n";
+        ok = false;
+    }
+    std::cout << "Storing " << nSpecs << " specs (seed " << seed << "): " << (ok ? "OK" : "FAILED") << "\n";
+    return ok;
+}
+
+// The memory report has to count every entity once in its total and its categories have to add up to the totals
+static bool checkMemoryReport(const unsigned int seed, const std::size_t nSpecs)
+{
+    std::vector<GeneratedSpec> specs;
+    Drock::Model dc;
+    if (!importGenerated(seed, nSpecs, dc, specs))
+        return false;
+    std::stringstream ss;
+    dc.reportMemory(ss);
+    YAML::Node report;
+    try {
+        report = YAML::Load(ss.str());
+    } catch (const YAML::Exception& e) {
+        std::cout << "Cannot decode memory report: " << e.what() << "\n";
+        return false;
+    }
+
+    bool ok = true;
+    const std::size_t nEntities(dc.find().size());
+    if (report["total"]["entities"].as<std::size_t>() != nEntities)
+    {
+        std::cout << "Memory report counts " << report["total"]["entities"].as<std::size_t>() << " instead of " << nEntities << " entities\n";
+        ok = false;
+    }
+    // Check the total and every breakdown by domain and by type
+    std::vector< std::pair<std::string, YAML::Node> > footprints;
+    footprints.push_back(std::make_pair("total", report["total"]));
+    const std::vector<std::string> keys = {"domains", "types"};
+    for (const std::string& key : keys)
+    {
+        for (auto it = report[key].begin(); it != report[key].end(); it++)
+            footprints.push_back(std::make_pair(key+"/"+it->first.as<std::string>(), it->second));
+    }
+    const std::vector<std::string> fields = {"entities", "uidBytes", "labelBytes", "referenceBytes", "overheadBytes", "bytes"};
+    for (const auto& entry : footprints)
+    {
+        const YAML::Node& categories(entry.second["categories"]);
+        for (const std::string& field : fields)
+        {
+            std::size_t sum = 0;
+            for (auto it = categories.begin(); it != categories.end(); it++)
+                sum += it->second[field].as<std::size_t>();
+            if (sum == entry.second[field].as<std::size_t>())
+                continue;
+            std::cout << "Categories of " << entry.first << " sum up to " << sum << " " << field << " instead of " << entry.second[field].as<std::size_t>() << "\n";
+            ok = false;
+        }
+        const std::size_t bytes(entry.second["uidBytes"].as<std::size_t>() + entry.second["labelBytes"].as<std::size_t>() +
+                                entry.second["referenceBytes"].as<std::size_t>() + entry.second["overheadBytes"].as<std::size_t>());
+        if (bytes != entry.second["bytes"].as<std::size_t>())
+        {
+            std::cout << "Bytes of " << entry.first << " are not the sum of their parts\n";
+            ok = false;
+        }
+    }
+    std::cout << "Memory report of " << nSpecs << " specs (seed " << seed << "): " << (ok ? "OK" : "FAILED") << "\n";
+    return ok;
+}
+
+// Exports are served from the cache until the component is imported again, exports of other components stay the same
+static bool checkExportCache(const unsigned int seed, const std::size_t nSpecs)
+{
+    std::vector<GeneratedSpec> specs;
+    Drock::Model dc;
+    if (!importGenerated(seed, nSpecs, dc, specs))
+        return false;
+    if (specs.size() < 2)
+    {
+        std::cout << "Checking the export cache needs at least two specs\n";
+        return false;
+    }
+    const GeneratedSpec& changing(specs.back());
+    const GeneratedSpec& unrelated(specs.front());
+    const UniqueId changingUid(dc.getComponentUid(changing.domain, changing.name));
+    const UniqueId unrelatedUid(dc.getComponentUid(unrelated.domain, unrelated.name));
+
+    bool ok = true;
+    const std::string before(dc.domainSpecificExport(changingUid));
+    const std::string unrelatedBefore(dc.domainSpecificExport(unrelatedUid));
+    if (dc.domainSpecificExport(changingUid) != before)
+    {
+        std::cout << "Repeated export of " << changing.name << " differs\n";
+        ok = false;
+    }
+
+    // Import the component again with two more nodes, an edge between them and a config
+    YAML::Node spec(YAML::Load(before));
+    YAML::Node componentsYAML(spec["versions"][0]["components"]);
+    for (std::size_t i = 0; i < 2; i++)
+    {
+        YAML::Node nodeYAML;
+        nodeYAML["name"] = "extra"+std::to_string(i);
+        nodeYAML["model"]["domain"] = unrelated.domain;
+        nodeYAML["model"]["name"] = unrelated.name;
+        nodeYAML["model"]["version"] = unrelated.versions.front().name;
+        componentsYAML["nodes"].push_back(nodeYAML);
+    }
+    YAML::Node edgeYAML;
+    edgeYAML["name"] = "extraEdge";
+    edgeYAML["type"] = "DEPENDS_ON";
+    edgeYAML["from"]["name"] = "extra0";
+    edgeYAML["to"]["name"] = "extra1";
+    componentsYAML["edges"].push_back(edgeYAML);
+    YAML::Node nodeConfigYAML;
+    nodeConfigYAML["name"] = "extra0";
+    nodeConfigYAML["data"] = "extra-config";
+    componentsYAML["configuration"]["nodes"].push_back(nodeConfigYAML);
+    if (!dc.domainSpecificImport(serialize(spec)))
+    {
+        std::cout << "Re-import of " << changing.name << " failed\n";
+        return false;
+    }
+
+    const std::string after(dc.domainSpecificExport(changingUid));
+    if (after == before)
+    {
+        std::cout << "Export of " << changing.name << " has not been updated\n";
+        ok = false;
+    }
+    ok = equivalent(canonical(spec), canonical(YAML::Load(after)), "Export of changed "+changing.name) && ok;
+    if (dc.domainSpecificExport(unrelatedUid) != unrelatedBefore)
+    {
+        std::cout << "Export of unrelated " << unrelated.name << " changed\n";
+        ok = false;
+    }
+    std::cout << "Export cache of " << nSpecs << " specs (seed " << seed << "): " << (ok ? "OK" : "FAILED") << "\n";
+    return ok;
+}
+
+// Importing the specs at once in any order has to yield the same exports as importing them one by one
+static bool checkScheduledImport(const unsigned int seed, const std::size_t nSpecs)
+{
+    std::vector<GeneratedSpec> specs;
+    Drock::Model sequential;
+    if (!importGenerated(seed, nSpecs, sequential, specs))
+        return false;
+    std::vector<std::string> serialized;
+    for (const GeneratedSpec& spec : specs)
+        serialized.push_back(serialize(spec.spec));
+    std::mt19937 rng(seed);
+    std::shuffle(serialized.begin(), serialized.end(), rng);
+
+    bool ok = true;
+    Drock::Model scheduled;
+    setupRelations(scheduled);
+    if (!scheduled.domainSpecificImport(serialized))
+    {
+        std::cout << "Import of shuffled specs failed\n";
+        ok = false;
+    }
+    for (const GeneratedSpec& spec : specs)
+    {
+        const std::string expected(sequential.domainSpecificExport(sequential.getComponentUid(spec.domain, spec.name)));
+        const std::string actual(scheduled.domainSpecificExport(scheduled.getComponentUid(spec.domain, spec.name)));
+        ok = equivalent(canonical(YAML::Load(expected)), canonical(YAML::Load(actual)), "Scheduled import of "+spec.name) && ok;
+    }
+
+    // A spec referring to an unknown model must not be imported (and neither the ones using it)
+    // NOTE: The first spec has no parts, so only the unknown model is missing
+    const GeneratedSpec& first(specs.front());
+    YAML::Node broken(YAML::Clone(first.spec));
+    broken["name"] = "broken";
+    YAML::Node missingYAML;
+    missingYAML["name"] = "missing";
+    missingYAML["model"]["domain"] = "SOFTWARE";
+    missingYAML["model"]["name"] = "missing";
+    missingYAML["model"]["version"] = "v0";
+    broken["versions"][0]["components"]["nodes"].push_back(missingYAML);
+    YAML::Node user;
+    user["domain"] = first.domain;
+    user["type"] = "TASK";
+    user["name"] = "user";
+    YAML::Node userVersion;
+    userVersion["name"] = "v0";
+    YAML::Node brokenYAML;
+    brokenYAML["name"] = "broken";
+    brokenYAML["model"]["domain"] = first.domain;
+    brokenYAML["model"]["name"] = "broken";
+    brokenYAML["model"]["version"] = first.versions.front().name;
+    userVersion["components"]["nodes"].push_back(brokenYAML);
+    user["versions"].push_back(userVersion);
+    if (scheduled.domainSpecificImport(std::vector<std::string>{serialize(user), serialize(broken)}) ||
+        scheduled.exists(scheduled.getComponentUid(first.domain, "broken")) ||
+        scheduled.exists(scheduled.getComponentUid(first.domain, "user")))
+    {
+        std::cout << "Specs referring to unknown models have been imported\n";
+        ok = false;
+    }
+    std::cout << "Scheduled import of " << nSpecs << " specs (seed " << seed << "): " << (ok ? "OK" : "FAILED") << "\n";
+    return ok;
+}
+
+// Every component has to be exported the same after storing all shards and loading only the one of its domain
+static bool checkShards(const unsigned int seed, const std::size_t nSpecs)
+{
+    std::vector<GeneratedSpec> specs;
+    Drock::Model full;
+    if (!importGenerated(seed, nSpecs, full, specs))
+        return false;
+    std::set<std::string> domains;
+    std::vector<std::string> exported;
+    for (const GeneratedSpec& spec : specs)
+    {
+        domains.insert(spec.domain);
+        exported.push_back(full.domainSpecificExport(full.getComponentUid(spec.domain, spec.name)));
+    }
+
+    char directoryTemplate[] = "/tmp/drock-shards-XXXXXX";
+    if (!mkdtemp(directoryTemplate))
+    {
+        std::cout << "Cannot create shard directory\n";
+        return false;
+    }
+    const std::string directory(directoryTemplate);
+    bool ok = full.saveShards(directory);
+    if (!ok)
+        std::cout << "Cannot store shards in " << directory << "\n";
+
+    for (const std::string& domain : domains)
+    {
+        if (!ok)
+            break;
+        Drock::Model partial;
+        if (!partial.loadShards(directory, std::vector<std::string>{domain}, true))
+        {
+            std::cout << "Cannot load shard " << domain << "\n";
+            ok = false;
+            break;
+        }
+        for (std::size_t i = 0; i < specs.size(); i++)
+        {
+            if (specs[i].domain != domain)
+                continue;
+            const std::string reexported(partial.domainSpecificExport(partial.getComponentUid(specs[i].domain, specs[i].name)));
+            ok = equivalent(canonical(YAML::Load(exported[i])), canonical(YAML::Load(reexported)), "Export of "+specs[i].name+" from shard "+domain) && ok;
+        }
+    }
+
+    // A broken manifest has to be reported instead of aborting
+    if (ok)
+    {
+        std::ofstream(directory+"/shards.yml") << "core: [unterminated\n";
+        Drock::Model broken;
+        if (broken.loadShards(directory, std::vector<std::string>(domains.begin(), domains.end())))
+        {
+            std::cout << "Broken manifest in " << directory << " has been loaded\n";
+            ok = false;
+        }
+    }
+
+    // Clean up
+    for (const std::string& domain : domains)
+        std::remove((directory+"/"+domain+".yml").c_str());
+    std::remove((directory+"/core.yml").c_str());
+    std::remove((directory+"/shards.yml").c_str());
+    rmdir(directory.c_str());
+    std::cout << "Shards of " << nSpecs << " specs (seed " << seed << "): " << (ok ? "OK" : "FAILED") << "\n";
+    return ok;
+}
+
+// The connectivity index updated import by import has to match the one built from scratch
+static bool checkConnectivity(const unsigned int seed, const std::size_t nSpecs)
+{
+    std::vector<GeneratedSpec> specs;
+    Drock::Model dc;
+    std::vector<UniqueId> versionUids;
+    const bool imported(importGenerated(seed, nSpecs, dc, specs, [&](const GeneratedSpec& spec) {
+        for (const GeneratedVersion& version : spec.versions)
+            versionUids.push_back(dc.getComponentUid(spec.domain, spec.name, version.name));
+        // Query in between to update the index incrementally
+        dc.reachableFrom(Hyperedges{versionUids.back()});
+    }));
+    if (!imported)
+        return false;
+    std::vector< std::map<UniqueId, std::size_t> > incremental;
+    for (const UniqueId& versionUid : versionUids)
+        incremental.push_back(dc.distancesFrom(Hyperedges{versionUid}, TraversalDirection::BOTH));
+
+    dc.invalidate();
+    bool ok = true;
+    for (std::size_t i = 0; i < versionUids.size(); i++)
+    {
+        if (dc.distancesFrom(Hyperedges{versionUids[i]}, TraversalDirection::BOTH) == incremental[i])
+            continue;
+        std::cout << "Connectivity of " << versionUids[i] << " differs after rebuild\n";
+        ok = false;
+    }
+    std::cout << "Connectivity of " << nSpecs << " specs (seed " << seed << "): " << (ok ? "OK" : "FAILED") << "\n";
+    return ok;
+}
+
+// A spec of a SOFTWARE TASK with the given interfaces, parts, interface connections and aliases
+static YAML::Node nestedSpec(const std::string& name, const std::vector<std::string>& nodes, const std::vector<std::string>& models,
+                             const std::vector< std::pair<std::string, std::string> >& connections,
+                             const std::vector<std::string>& aliases)
+{
+    YAML::Node spec;
+    spec["domain"] = "SOFTWARE";
+    spec["type"] = "TASK";
+    spec["name"] = name;
+    YAML::Node version;
+    version["name"] = "v0";
+    for (std::size_t p = 0; p < nodes.size(); p++)
+    {
+        YAML::Node nodeYAML;
+        nodeYAML["name"] = nodes[p];
+        nodeYAML["model"]["domain"] = "SOFTWARE";
+        nodeYAML["model"]["name"] = models[p];
+        nodeYAML["model"]["version"] = "v0";
+        version["components"]["nodes"].push_back(nodeYAML);
+    }
+    // Connections always lead from the out interface of one part to the in interface of another
+    for (std::size_t e = 0; e < connections.size(); e++)
+    {
+        YAML::Node edgeYAML;
+        edgeYAML["name"] = "conn"+std::to_string(e);
+        edgeYAML["from"]["name"] = connections[e].first;
+        edgeYAML["from"]["interface"] = "out";
+        edgeYAML["to"]["name"] = connections[e].second;
+        edgeYAML["to"]["interface"] = "in";
+        version["components"]["edges"].push_back(edgeYAML);
+    }
+    // The in and out interfaces are either new or aliases of the ones of the given parts
+    const char* interfaces[] = {"in", "out"};
+    const char* directions[] = {"INCOMING", "OUTGOING"};
+    for (std::size_t i = 0; i < 2; i++)
+    {
+        YAML::Node interfaceYAML;
+        interfaceYAML["name"] = interfaces[i];
+        interfaceYAML["type"] = "INT";
+        interfaceYAML["direction"] = directions[i];
+        if (aliases.size())
+        {
+            interfaceYAML["linkToNode"] = aliases[i];
+            interfaceYAML["linkToInterface"] = interfaces[i];
+        }
+        version["interfaces"].push_back(interfaceYAML);
+    }
+    spec["versions"].push_back(version);
+    return spec;
+}
+
+// Counts the parts and interface connections of an instance and of all its parts (and their parts etc.)
+static void countExpansion(Drock::Model& dc, const UniqueId& uid, std::size_t& nParts, std::size_t& nConnections)
+{
+    Hyperedges partUids(dc.componentsOf(Hyperedges{uid}));
+    Hyperedges interfaceUids(dc.interfacesOf(partUids));
+    nParts += partUids.size();
+    nConnections += dc.factsBetween(Component::Network::ConnectedToInterfaceId, interfaceUids, interfaceUids).size();
+    for (const UniqueId& partUid : partUids)
+        countExpansion(dc, partUid, nParts, nConnections);
+}
+
+// Deep instantiation of a three level model reusing a subassembly has to reproduce the whole structure
+static bool checkDeepInstantiation()
+{
+    Drock::Model dc;
+    dc.domainSpecificImport(serialize(nestedSpec("leaf", {}, {}, {}, {})));
+    dc.domainSpecificImport(serialize(nestedSpec("sub", {"a", "b"}, {"leaf", "leaf"}, {{"a", "b"}}, {"a", "b"})));
+    dc.domainSpecificImport(serialize(nestedSpec("top", {"s1", "s2", "l"}, {"sub", "sub", "leaf"}, {{"s1", "s2"}, {"s2", "l"}}, {"s1", "l"})));
+
+    bool ok = true;
+    Hyperedges instanceUids(dc.instantiateDeepFrom(Hyperedges{dc.getComponentUid("SOFTWARE", "top", "v0")}, "instance"));
+    if (instanceUids.size() != 1)
+    {
+        std::cout << "Deep instantiation created " << instanceUids.size() << " instances\n";
+        return false;
+    }
+    const UniqueId instanceUid(*instanceUids.begin());
+    // top has 3 parts and both subassemblies have 2 more, top has 2 connections and every subassembly 1 more
+    std::size_t nParts(0), nConnections(0);
+    countExpansion(dc, instanceUid, nParts, nConnections);
+    if ((nParts != 7) || (nConnections != 4))
+    {
+        std::cout << "Deep instance has " << nParts << " parts and " << nConnections << " connections, expected 7 and 4\n";
+        ok = false;
+    }
+    // Aliases connect the interfaces of every instance to the ones of its parts, so everything is reachable from the outside
+    const std::size_t nReachable(dc.reachableFrom(instanceUids, TraversalDirection::BOTH).size());
+    if (nReachable != 7)
+    {
+        std::cout << "Deep instance reaches " << nReachable << " parts, expected 7\n";
+        ok = false;
+    }
+    std::cout << "Deep instantiation: " << (ok ? "OK" : "FAILED") << "\n";
+    return ok;
+}
+
+// Builds a reference model with <size> interconnected parts and times import and export
+static YAML::Node timeReference(const std::size_t size)
+{
+    YAML::Node leaf;
+    leaf["domain"] = "SOFTWARE";
+    leaf["type"] = "TASK";
+    leaf["name"] = "leaf";
+    YAML::Node leafVersion;
+    leafVersion["name"] = "v0";
+    const char* directions[] = {"INCOMING", "OUTGOING"};
+    for (std::size_t i = 0; i < 4; i++)
+    {
+        YAML::Node interfaceYAML;
+        interfaceYAML["name"] = std::string(directions[i % 2])+std::to_string(i / 2);
+        interfaceYAML["type"] = "INT";
+        interfaceYAML["direction"] = directions[i % 2];
+        leafVersion["interfaces"].push_back(interfaceYAML);
+    }
+    leaf["versions"].push_back(leafVersion);
+
+    YAML::Node reference;
+    reference["domain"] = "SOFTWARE";
+    reference["type"] = "TASK";
+    reference["name"] = "reference";
+    YAML::Node version;
+    version["name"] = "v0";
+    for (std::size_t p = 0; p < size; p++)
+    {
+        YAML::Node nodeYAML;
+        nodeYAML["name"] = "node"+std::to_string(p);
+        nodeYAML["model"]["domain"] = "SOFTWARE";
+        nodeYAML["model"]["name"] = "leaf";
+        nodeYAML["model"]["version"] = "v0";
+        version["components"]["nodes"].push_back(nodeYAML);
+        YAML::Node nodeConfigYAML;
+        nodeConfigYAML["name"] = "node"+std::to_string(p);
+        nodeConfigYAML["data"] = "config"+std::to_string(p);
+        version["components"]["configuration"]["nodes"].push_back(nodeConfigYAML);
+        if (!p)
+            continue;
+        // Chain the parts via interfaces and relate each one to its predecessor
+        YAML::Node connYAML;
+        connYAML["name"] = "conn"+std::to_string(p);
+        connYAML["from"]["name"] = "node"+std::to_string(p-1);
+        connYAML["from"]["interface"] = "OUTGOING0";
+        connYAML["to"]["name"] = "node"+std::to_string(p);
+        connYAML["to"]["interface"] = "INCOMING0";
+        version["components"]["edges"].push_back(connYAML);
+        YAML::Node relYAML;
+        relYAML["name"] = "rel"+std::to_string(p);
+        relYAML["type"] = "DEPENDS_ON";
+        relYAML["from"]["name"] = "node"+std::to_string(p);
+        relYAML["to"]["name"] = "node"+std::to_string(p-1);
+        version["components"]["edges"].push_back(relYAML);
+    }
+    reference["versions"].push_back(version);
+
+    YAML::Node timings;
+    Drock::Model dc;
+    setupRelations(dc);
+    dc.domainSpecificImport(serialize(leaf));
+    const std::string serialized(serialize(reference));
+    std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+    dc.domainSpecificImport(serialized);
+    timings["import"] = msSince(start);
+    start = std::chrono::steady_clock::now();
+    const std::string exported(dc.domainSpecificExport(dc.getComponentUid("SOFTWARE", "reference")));
+    timings["export"] = msSince(start);
+    start = std::chrono::steady_clock::now();
+    dc.domainSpecificImport(exported);
+    timings["reimport"] = msSince(start);
+    timings["size"] = size;
+    return timings;
+}
+
+static bool withinLimit(const std::string& what, const double ms, const double limitMs)
+{
+    if ((limitMs <= 0.) || (ms <= limitMs))
+        return true;
+    std::cout << what << " took " << ms << " ms, limit is " << limitMs << " ms\n";
+    return false;
+}
+
+// This tool checks that import and export round-trip and records how long they take
+int main (int argc, char **argv)
+{
+    unsigned int seed = 1;
+    std::size_t nSpecs = 20;
+    std::size_t size = 0;
+    double maxImportMs = 0.;
+    double maxExportMs = 0.;
+    double tolerance = 1.5;
+    std::string fileNameTimings;
+    std::string fileNameBaseline;
+    std::set<std::string> checkNames;
+
+    // Parse command line
+    int c;
+    while (1)
+    {
+        int option_index = 0;
+        c = getopt_long(argc, argv, "hs:n:z:i:e:t:b:r:c:", long_options, &option_index);
+        if (c == -1)
+            break;
+
+        switch (c)
+        {
+            case 's':
+                seed = std::strtoul(optarg, NULL, 10);
+                break;
+            case 'n':
+                nSpecs = std::strtoul(optarg, NULL, 10);
+                break;
+            case 'z':
+                size = std::strtoul(optarg, NULL, 10);
+                break;
+            case 'i':
+                maxImportMs = std::strtod(optarg, NULL);
+                break;
+            case 'e':
+                maxExportMs = std::strtod(optarg, NULL);
+                break;
+            case 't':
+                fileNameTimings = optarg;
+                break;
+            case 'b':
+                fileNameBaseline = optarg;
+                break;
+            case 'r':
+                tolerance = std::strtod(optarg, NULL);
+                break;
+            case 'c':
+                checkNames.insert(optarg);
+                break;
+            case 'h':
+            case '?':
+                usage(argv[0]);
+                return 1;
+            default:
+                std::cout << "W00t?!\n";
+                return 1;
+        }
+    }
+
+    // Every check fails with its own exit code
+    struct Check
+    {
+        std::string name;
+        int code;
+        std::function<bool ()> run;
+    };
+    const std::vector<Check> checks = {
+        {"roundtrip", 4, [&]() { return checkRoundTrip(seed, nSpecs); }},
+        {"connectivity", 6, [&]() { return checkConnectivity(seed, nSpecs); }},
+        {"deep-instantiation", 7, [&]() { return checkDeepInstantiation(); }},
+        {"shards", 8, [&]() { return checkShards(seed, nSpecs); }},
+        {"scheduled-import", 9, [&]() { return checkScheduledImport(seed, nSpecs); }},
+        {"export-cache", 10, [&]() { return checkExportCache(seed, nSpecs); }},
+        {"save", 11, [&]() { return checkSave(seed, nSpecs); }},
+        {"memory-report", 12, [&]() { return checkMemoryReport(seed, nSpecs); }}
+    };
+    for (const std::string& checkName : checkNames)
+    {
+        bool known = false;
+        for (const Check& check : checks)
+            known = known || (check.name == checkName);
+        if (!known)
+        {
+            std::cout << "Unknown check " << checkName << "\n";
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    for (const Check& check : checks)
+    {
+        if (checkNames.empty() ? !nSpecs : !checkNames.count(check.name))
+            continue;
+        if (!check.run())
+            return check.code;
+    }
+
+    if (!size)
+        return 0;
+
+    YAML::Node timings(timeReference(size));
+    std::cout << "Reference model with " << size << " parts:\n" << timings << "\n";
+    if (!fileNameTimings.empty())
+    {
+        std::ofstream fout;
+        fout.open(fileNameTimings);
+        if(!fout.good()) {
+            std::cout << "WRITE FAILED\n";
+            return 2;
+        }
+        fout << timings << std::endl;
+        fout.close();
+    }
+
+    bool ok = true;
+    ok = withinLimit("Import", timings["import"].as<double>(), maxImportMs) && ok;
+    ok = withinLimit("Re-import", timings["reimport"].as<double>(), maxImportMs) && ok;
+    ok = withinLimit("Export", timings["export"].as<double>(), maxExportMs) && ok;
+    if (!fileNameBaseline.empty())
+    {
+        YAML::Node baseline(YAML::LoadFile(fileNameBaseline));
+        if (baseline["size"].as<std::size_t>() != size)
+        {
+            std::cout << "Baseline has been recorded for " << baseline["size"].as<std::size_t>() << " parts. Skipping comparison\n";
+        } else {
+            ok = withinLimit("Import", timings["import"].as<double>(), tolerance * baseline["import"].as<double>()) && ok;
+            ok = withinLimit("Re-import", timings["reimport"].as<double>(), tolerance * baseline["reimport"].as<double>()) && ok;
+            ok = withinLimit("Export", timings["export"].as<double>(), tolerance * baseline["export"].as<double>()) && ok;
+        }
+    }
+    return ok ? 0 : 5;
+}
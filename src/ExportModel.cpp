@@ -1,5 +1,6 @@
 #include "BasicModel.hpp"
 #include "HypergraphYAML.hpp"
+#include "Trace.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -9,34 +10,55 @@
 
 static struct option long_options[] = {
     {"help", no_argument, 0, 'h'},
+    {"shards", required_argument, 0, 's'},
+    {"trace", required_argument, 0, 't'},
+    {"mem-report", required_argument, 0, 'm'},
     {0,0,0,0}
 };
 
 void usage (const char *myName)
 {
     std::cout << "Usage:\n";
-    std::cout << myName << " <yaml-file-in> <yaml-file-out>\n\n";
+    std::cout << myName << " <yaml-file-in> <yaml-file-out>\n";
+    std::cout << myName << " --shards <shard-dir> <yaml-file-out>\n\n";
     std::cout << "Options:\n";
     std::cout << "--help\t" << "Show usage\n";
+    std::cout << "--shards <dir>\t" << "Load only the shard of the model (and the ones it depends on) from <dir>\n";
+    std::cout << "--trace <json-file>\t" << "Record the timing of all model operations as Chrome trace events (needs DROCK_TRACING)\n";
+    std::cout << "--mem-report <yaml-file>\t" << "Store the estimated memory footprint of the model per category, domain and type\n";
     std::cout << "\nExample:\n";
     std::cout << myName << "drock-domain-as-hypergraph.yml name-of-basic-model-to-export.yml\n";
+    std::cout << myName << "--shards drock-shards name-of-basic-model-to-export.yml\n";
 }
 
 // This tool takes a language definition and tries to interpret a given domain specific format given that definition
 int main (int argc, char **argv)
 {
 
+    std::string shardDirectory;
+    std::string memReportFileName;
+
     // Parse command line
     int c;
     while (1)
     {
         int option_index = 0;
-        c = getopt_long(argc, argv, "h", long_options, &option_index);
+        c = getopt_long(argc, argv, "hs:t:m:", long_options, &option_index);
         if (c == -1)
             break;
 
         switch (c)
         {
+            case 's':
+                shardDirectory = optarg;
+                break;
+            case 't':
+                if (!Drock::Trace::start(optarg))
+                    std::cout << "Tracing not available. Rebuild with -DDROCK_TRACING=ON\n";
+                break;
+            case 'm':
+                memReportFileName = optarg;
+                break;
             case 'h':
             case '?':
                 break;
@@ -46,25 +68,40 @@ int main (int argc, char **argv)
         }
     }
 
-    if ((argc - optind) < 2)
+    if ((argc - optind) < (shardDirectory.empty() ? 2 : 1))
     {
         usage(argv[0]);
         return 1;
     }
 
     // Set vars
-    std::string fileNameIn(argv[optind]);
-    std::string fileNameOut(argv[optind+1]);
+    std::string fileNameOut(argv[shardDirectory.empty() ? optind+1 : optind]);
+    std::size_t pos(fileNameOut.rfind("."));
+    std::string name(fileNameOut.substr(0,pos));
 
-    // Load file and convert to Drock::Computaution model
-    Hypergraph hg(YAML::LoadFile(fileNameIn).as<Hypergraph>());
-    Drock::Model dc(hg);
+    Drock::Model dc;
+    if (!shardDirectory.empty())
+    {
+        // Load the shard of the model's domain and everything it refers to
+        if (!dc.loadShards(shardDirectory, std::vector<std::string>{Drock::Model::domainOf(name)}, true)) {
+            std::cout << "READ FAILED\n";
+            return 3;
+        }
+    } else {
+        // Load file and convert to Drock::Computaution model
+        std::string fileNameIn(argv[optind]);
+        dc.merge(YAML::LoadFile(fileNameIn).as<Hypergraph>());
+    }
 
     // Call domain specific export
-    std::size_t pos(fileNameOut.rfind("."));
-    std::string name(fileNameOut.substr(0,pos));
     std::string result(dc.domainSpecificExport(name));
 
+    // Report the memory footprint of the loaded model
+    if (!memReportFileName.empty() && !dc.reportMemory(memReportFileName)) {
+        std::cout << "WRITE FAILED\n";
+        return 2;
+    }
+
     // Store export
     std::ofstream fout;
     fout.open(fileNameOut);
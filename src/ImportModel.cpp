@@ -1,5 +1,6 @@
 #include "BasicModel.hpp"
 #include "HypergraphYAML.hpp"
+#include "Trace.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -9,35 +10,86 @@
 
 static struct option long_options[] = {
     {"help", no_argument, 0, 'h'},
+    {"shards", required_argument, 0, 's'},
+    {"trace", required_argument, 0, 't'},
+    {"mem-report", required_argument, 0, 'm'},
+    {"spec", required_argument, 0, 'i'},
     {0,0,0,0}
 };
 
 void usage (const char *myName)
 {
     std::cout << "Usage:\n";
-    std::cout << myName << " <yaml-file-in> <yaml-file-out> (<yaml-file-in>)\n\n";
+    std::cout << myName << " <yaml-file-in> <yaml-file-out> (<yaml-file-in> ...)\n";
+    std::cout << myName << " --shards <shard-dir> <yaml-file-in>\n\n";
     std::cout << "Options:\n";
     std::cout << "--help\t" << "Show usage\n";
+    std::cout << "--shards <dir>\t" << "Load only the shards needed by the spec from <dir> and store the result there\n";
+    std::cout << "--trace <json-file>\t" << "Record the timing of all model operations as Chrome trace events (needs DROCK_TRACING)\n";
+    std::cout << "--mem-report <yaml-file>\t" << "Store the estimated memory footprint of the model per category, domain and type\n";
+    std::cout << "--spec <yaml-file-in>\t" << "Import another spec (can be given multiple times, specs are imported in dependency order)\n";
+    std::cout << "\nAll specs (even a single one) are validated first: Specs referring to models which are neither known nor given are skipped\n";
     std::cout << "\nExample:\n";
     std::cout << myName << "drock-basic-model-from-db.yml drock-domain-as-hypergraph.yml\n";
     std::cout << myName << "drock-basic-model-from-db.yml drock-domain-as-hypergraph.yml other-hypergraph.yml\n";
+    std::cout << myName << "drock-basic-model-from-db.yml drock-domain-as-hypergraph.yml software-hypergraph.yml hardware-hypergraph.yml\n";
+    std::cout << myName << "--shards drock-shards drock-basic-model-from-db.yml\n";
+    std::cout << myName << "--spec other-model-from-db.yml drock-basic-model-from-db.yml drock-domain-as-hypergraph.yml\n";
+}
+
+// The domain of the spec and all domains its parts come from
+std::vector<std::string> domainsOf(const std::string& serialized)
+{
+    std::vector<std::string> result;
+    YAML::Node spec(YAML::Load(serialized));
+    if (spec["domain"].IsDefined())
+        result.push_back(spec["domain"].as<std::string>());
+    const YAML::Node& versions(spec["versions"]);
+    for (auto it = versions.begin(); it != versions.end(); it++)
+    {
+        const YAML::Node& nodes((*it)["components"]["nodes"]);
+        for (auto nit = nodes.begin(); nit != nodes.end(); nit++)
+        {
+            const YAML::Node& model((*nit)["model"]);
+            if (model["domain"].IsDefined())
+                result.push_back(model["domain"].as<std::string>());
+        }
+    }
+    return result;
 }
 
 // This tool takes a language definition and tries to interpret a given domain specific format given that definition
 int main (int argc, char **argv)
 {
 
+    std::string shardDirectory;
+    std::string memReportFileName;
+    std::vector<std::string> fileNamesIn;
+
     // Parse command line
     int c;
     while (1)
     {
         int option_index = 0;
-        c = getopt_long(argc, argv, "h", long_options, &option_index);
+        c = getopt_long(argc, argv, "hs:i:t:m:", long_options, &option_index);
         if (c == -1)
             break;
 
         switch (c)
         {
+            case 's':
+                shardDirectory = optarg;
+                break;
+            case 't':
+                if (!Drock::Trace::start(optarg))
+                    std::cout << "Tracing not available. Rebuild with -DDROCK_TRACING=ON\n";
+                break;
+            case 'm':
+                memReportFileName = optarg;
+                break;
+            case 'i':
+                fileNamesIn.push_back(optarg);
+                break;
             case 'h':
             case '?':
                 break;
@@ -47,61 +99,88 @@ int main (int argc, char **argv)
         }
     }
 
-    if ((argc - optind) < 2)
+    if ((argc - optind) < (shardDirectory.empty() ? 2 : 1))
     {
         usage(argv[0]);
         return 1;
     }
 
     // Set vars
-    std::string fileNameIn(argv[optind]);
-    std::string fileNameOut(argv[optind+1]);
+    fileNamesIn.insert(fileNamesIn.begin(), std::string(argv[optind]));
 
-    // Load file and convert to string
-    std::ifstream fin;
-    fin.open(fileNameIn);
-    if(!fin.good()) {
-        std::cout << "READ FAILED\n";
-        return 2;
+    // Load files and convert to strings
+    std::vector<std::string> specs;
+    std::vector<std::string> domains;
+    for (const std::string& fileNameIn : fileNamesIn)
+    {
+        std::ifstream fin;
+        fin.open(fileNameIn);
+        if(!fin.good()) {
+            std::cout << "READ FAILED\n";
+            return 2;
+        }
+        std::stringstream ss;
+        ss << fin.rdbuf();
+        fin.close();
+        specs.push_back(ss.str());
+        if (!shardDirectory.empty())
+        {
+            std::vector<std::string> specDomains(domainsOf(specs.back()));
+            domains.insert(domains.end(), specDomains.begin(), specDomains.end());
+        }
     }
-    std::stringstream ss;
-    ss << fin.rdbuf();
 
-    if ((argc - optind) > 2)
+    Drock::Model dc;
+    if (!shardDirectory.empty())
     {
-        std::string fileNameIn2(argv[optind+2]);
-        Hypergraph hg(YAML::LoadFile(fileNameIn2).as<Hypergraph>());
-        Drock::Model dc(hg);
+        // Load only the shards of the domains the specs refer to
+        // NOTE: A directory without manifest is fresh and gets populated by saveShards below
+        if (!dc.loadShards(shardDirectory, domains) && std::ifstream(shardDirectory+"/shards.yml").good()) {
+            std::cout << "READ FAILED\n";
+            return 2;
+        }
 
         // Call domain specific import
-        dc.domainSpecificImport(ss.str());
+        // NOTE: A single spec is scheduled as well, so it gets validated the same way
+        dc.domainSpecificImport(specs);
 
-        // Store imported graph
-        std::ofstream fout;
-        fout.open(fileNameOut);
-        if(!fout.good()) {
+        // Report the memory footprint of the resulting model
+        if (!memReportFileName.empty() && !dc.reportMemory(memReportFileName)) {
             std::cout << "WRITE FAILED\n";
             return 3;
         }
-        fout << YAML::StringFrom(dc) << std::endl;
-        fout.close();
-        fin.close();
-    } else {
-        Drock::Model dc;
 
-        // Call domain specific import
-        dc.domainSpecificImport(ss.str());
-
-        // Store imported graph
-        std::ofstream fout;
-        fout.open(fileNameOut);
-        if(!fout.good()) {
+        // Store the loaded shards (and the core)
+        // NOTE: New relations between domains may belong to any of the loaded shards
+        if (!dc.saveShards(shardDirectory)) {
             std::cout << "WRITE FAILED\n";
             return 3;
         }
-        fout << YAML::StringFrom(dc) << std::endl;
-        fout.close();
-        fin.close();
+        return 0;
+    }
+
+    // Merge all given base graphs in one pass (each loaded graph is released before loading the next one)
+    std::string fileNameOut(argv[optind+1]);
+    for (int i = optind+2; i < argc; i++)
+    {
+        std::string fileNameBase(argv[i]);
+        dc.merge(YAML::LoadFile(fileNameBase).as<Hypergraph>());
+    }
+
+    // Call domain specific import
+    // NOTE: A single spec is scheduled as well, so it gets validated the same way
+    dc.domainSpecificImport(specs);
+
+    // Report the memory footprint of the resulting model
+    if (!memReportFileName.empty() && !dc.reportMemory(memReportFileName)) {
+        std::cout << "WRITE FAILED\n";
+        return 3;
+    }
+
+    // Store imported graph (streamed entity by entity)
+    if (!dc.saveTo(fileNameOut)) {
+        std::cout << "WRITE FAILED\n";
+        return 3;
     }
 
     return 0;
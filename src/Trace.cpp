@@ -0,0 +1,160 @@
+#include "Trace.hpp"
+
+#ifdef DROCK_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace Drock {
+namespace Trace {
+
+namespace {
+
+struct Event
+{
+    const char* name;
+    Arguments args;
+    long long begin;
+    long long duration;
+    unsigned int threadId;
+};
+
+std::mutex mutex;
+std::atomic<bool> recording(false);
+std::string traceFileName;
+std::vector<Event> events;
+std::map<std::thread::id, unsigned int> threadIds;
+
+// Microseconds since an arbitrary (but fixed) point in time
+long long now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string escape(const std::string& text)
+{
+    std::string result;
+    for (const char c : text)
+    {
+        switch (c)
+        {
+            case '"':
+                result += "\\\"";
+                break;
+            case '\\':
+                result += "\\\\";
+                break;
+            case '\n':
+                result += "\\n";
+                break;
+            case '\t':
+                result += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    result += buffer;
+                } else {
+                    result += c;
+                }
+        }
+    }
+    return result;
+}
+
+void stopAtExit()
+{
+    stop();
+}
+
+}
+
+bool start(const std::string& fileName)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    static bool registered = false;
+    if (!registered)
+    {
+        std::atexit(stopAtExit);
+        registered = true;
+    }
+    traceFileName = fileName;
+    events.clear();
+    recording = true;
+    return true;
+}
+
+bool enabled()
+{
+    return recording;
+}
+
+bool stop()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!recording)
+        return false;
+    recording = false;
+
+    std::ofstream fout;
+    fout.open(traceFileName);
+    if (!fout.good())
+        return false;
+    fout << "{\"traceEvents\":[\n";
+    for (std::size_t i = 0; i < events.size(); i++)
+    {
+        const Event& event(events[i]);
+        fout << "{\"name\":\"" << escape(event.name) << "\",\"cat\":\"drock\",\"ph\":\"X\",\"pid\":1"
+             << ",\"tid\":" << event.threadId << ",\"ts\":" << event.begin << ",\"dur\":" << event.duration
+             << ",\"args\":{";
+        for (std::size_t a = 0; a < event.args.size(); a++)
+            fout << (a ? "," : "") << "\"" << escape(event.args[a].first) << "\":\"" << escape(event.args[a].second) << "\"";
+        fout << "}}" << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    fout << "],\"displayTimeUnit\":\"ms\"}\n";
+    fout.close();
+    events.clear();
+    return !fout.fail();
+}
+
+Span::Span(const char* name, const Arguments& args)
+: name(name), begin(0), active(recording)
+{
+    if (!active)
+        return;
+    this->args = args;
+    begin = now();
+}
+
+Span::~Span()
+{
+    if (!active)
+        return;
+    const long long end(now());
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!recording)
+        return;
+    std::map<std::thread::id, unsigned int>::iterator it(threadIds.find(std::this_thread::get_id()));
+    if (it == threadIds.end())
+        it = threadIds.insert(std::make_pair(std::this_thread::get_id(), static_cast<unsigned int>(threadIds.size()))).first;
+    Event event;
+    event.name = name;
+    event.args.swap(args);
+    event.begin = begin;
+    event.duration = end - begin;
+    event.threadId = it->second;
+    events.push_back(event);
+}
+
+}
+}
+
+#endif